@@ -0,0 +1,426 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated file created by the Jucer!
+
+  Creation date:  17 Oct 2026 11:52:40pm
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Jucer version: 1.12
+
+  ------------------------------------------------------------------------------
+
+  The Jucer is part of the JUCE library - "Jules' Utility Class Extensions"
+  Copyright 2004-6 by Raw Material Software ltd.
+
+  ==============================================================================
+*/
+
+//[Headers] You can add your own extra header files here...
+//[/Headers]
+
+#include "AudioDemoBenchmarkPage.h"
+#include "../SampleConversion.h"
+#include "../BatchDecoder.h"
+#include "../CoreAudioFormat.h"
+
+
+//[MiscUserDefs] You can add your own user definitions and misc code here...
+
+//==============================================================================
+namespace
+{
+    /** One of the conversions that the writers can ask for. */
+    struct ConversionKernel
+    {
+        const char* name;
+        SampleConversion::SampleFormat format;
+        bool isBigEndian, isDithered;
+    };
+
+    const ConversionKernel conversionKernels[] =
+    {
+        { "16-bit",                 SampleConversion::int16Format,      false,  false },
+        { "16-bit, dithered",       SampleConversion::int16Format,      false,  true  },
+        { "16-bit, big-endian",     SampleConversion::int16Format,      true,   false },
+        { "24-bit",                 SampleConversion::int24Format,      false,  false },
+        { "24-bit, dithered",       SampleConversion::int24Format,      false,  true  },
+        { "24-bit, big-endian",     SampleConversion::int24Format,      true,   false },
+        { "32-bit",                 SampleConversion::int32Format,      false,  false },
+        { "32-bit, big-endian",     SampleConversion::int32Format,      true,   false },
+        { "32-bit float",           SampleConversion::float32Format,    false,  false }
+    };
+}
+
+//==============================================================================
+/** Times each of the kernels that the writers convert their samples with, once
+    with the vector instructions that were picked for this CPU and once with plain
+    C++, and reports how many GB of float samples each gets through per second.
+    Each one's timed with stereo, and with the larger numbers of channels that
+    multitrack recordings have.
+*/
+class ConversionBenchmark  : public ThreadWithProgressWindow
+{
+public:
+    ConversionBenchmark()
+        : ThreadWithProgressWindow ("Timing the sample conversions...", true, true),
+          source (maxChannels, blockSize),
+          dest ((size_t) (maxChannels * blockSize * 8))
+    {
+        Random random (1);
+
+        for (int i = 0; i < maxChannels; ++i)
+            for (int j = 0; j < blockSize; ++j)
+                *source.getSampleData (i, j) = random.nextFloat() * 2.0f - 1.0f;
+    }
+
+    void run()
+    {
+        const int channelCounts[] = { 2, 8, maxChannels };
+        const int numChannelCounts = numElementsInArray (channelCounts);
+        const int numKernels = numElementsInArray (conversionKernels);
+
+        results << "Sample conversion, in GB/s of float input" << newLine;
+
+        for (int i = 0; i < numChannelCounts && ! threadShouldExit(); ++i)
+        {
+            const int numChannels = channelCounts[i];
+
+            results << newLine
+                    << (String (numChannels) + " channels").paddedRight (' ', 24)
+                    << String ("C++").paddedLeft (' ', 8)
+                    << String (SampleConversion::getInstructionSetName()).paddedLeft (' ', 8)
+                    << String ("Speed-up").paddedLeft (' ', 10) << newLine;
+
+            for (int j = 0; j < numKernels && ! threadShouldExit(); ++j)
+            {
+                const ConversionKernel& kernel = conversionKernels[j];
+                setProgress ((i * numKernels + j) / (double) (numChannelCounts * numKernels));
+                setStatusMessage (String (kernel.name) + ", " + String (numChannels) + " channels");
+
+                const double scalarSpeed = timeKernel (kernel, numChannels, false);
+                const double vectorSpeed = timeKernel (kernel, numChannels, true);
+
+                results << String (kernel.name).paddedRight (' ', 24)
+                        << String (scalarSpeed / 1.0e9, 2).paddedLeft (' ', 8)
+                        << String (vectorSpeed / 1.0e9, 2).paddedLeft (' ', 8)
+                        << (String (vectorSpeed / scalarSpeed, 1) + "x").paddedLeft (' ', 10) << newLine;
+            }
+        }
+    }
+
+    const String& getResults() const noexcept       { return results; }
+
+private:
+    //==============================================================================
+    enum { maxChannels = 64, blockSize = 4096 };
+
+    AudioSampleBuffer source;
+    HeapBlock<char> dest;
+    String results;
+
+    /** Converts the same block over and over for a tenth of a second, and returns
+        the number of bytes of floats that were converted per second.
+    */
+    double timeKernel (const ConversionKernel& kernel, int numChannels, bool useVectorInstructions)
+    {
+        SampleConversion::DitherState dither;
+        const int64 minimumTicks = Time::getHighResolutionTicksPerSecond() / 10;
+        const int64 startTicks = Time::getHighResolutionTicks();
+        int64 numBlocks = 0, elapsedTicks = 0;
+
+        do
+        {
+            for (int i = 0; i < 16; ++i)
+                SampleConversion::convertToInterleaved (source.getArrayOfChannels(), numChannels, dest,
+                                                        kernel.format, kernel.isBigEndian, blockSize,
+                                                        kernel.isDithered ? &dither : nullptr, useVectorInstructions);
+
+            numBlocks += 16;
+            elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+        }
+        while (elapsedTicks < minimumTicks && ! threadShouldExit());
+
+        return numBlocks * (double) (blockSize * numChannels * sizeof (float))
+                 / Time::highResolutionTicksToSeconds (elapsedTicks);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ConversionBenchmark);
+};
+
+//==============================================================================
+/** Decodes all the audio files in a folder with a BatchDecoder, on one thread and
+    then on more and more of them up to one per CPU, and reports how fast each goes.
+*/
+class BatchDecodingBenchmark  : public ThreadWithProgressWindow,
+                                public BatchDecoder::Callback
+{
+public:
+    BatchDecodingBenchmark (const File& folder)
+        : ThreadWithProgressWindow ("Timing the batch decoder...", true, true)
+    {
+        const String wildcard ("*" + format.getFileExtensions().joinIntoString (";*"));
+        folder.findChildFiles (files, File::findFiles, true, wildcard);
+    }
+
+    int getNumFiles() const noexcept                { return files.size(); }
+
+    void run()
+    {
+        const int numCpus = SystemStats::getNumCpus();
+        Array<int> threadCounts;
+
+        for (int n = 1; n < numCpus; n *= 2)
+            threadCounts.add (n);
+
+        threadCounts.add (numCpus);
+
+        // the first pass is only there to get the files into the OS's cache, so that
+        // it's the decoding that gets timed rather than the disk
+        setStatusMessage ("Reading the files...");
+        decodeAll (numCpus);
+
+        results << "Batch decoding, " << files.size() << " files, "
+                << String (numSamplesDecoded.get() * (double) sizeof (float) / (1024.0 * 1024.0), 1)
+                << " MB of decoded samples";
+
+        if (numFilesFailed.get() > 0)
+            results << " (" << numFilesFailed.get() << " files couldn't be read)";
+
+        results << newLine
+                << String ("Threads").paddedRight (' ', 10)
+                << String ("Files/s").paddedLeft (' ', 10)
+                << String ("MB/s").paddedLeft (' ', 10)
+                << String ("Speed-up").paddedLeft (' ', 10) << newLine;
+
+        double singleThreadSeconds = 0;
+
+        for (int i = 0; i < threadCounts.size() && ! threadShouldExit(); ++i)
+        {
+            const int numThreads = threadCounts.getUnchecked (i);
+            setProgress ((i + 1) / (double) (threadCounts.size() + 1));
+            setStatusMessage ("Decoding on " + String (numThreads) + (numThreads == 1 ? " thread..." : " threads..."));
+
+            const double seconds = jmax (1.0e-6, decodeAll (numThreads));
+
+            if (i == 0)
+                singleThreadSeconds = seconds;
+
+            results << String (numThreads).paddedRight (' ', 10)
+                    << String (files.size() / seconds, 1).paddedLeft (' ', 10)
+                    << String (numSamplesDecoded.get() * (double) sizeof (float) / (1024.0 * 1024.0 * seconds), 1).paddedLeft (' ', 10)
+                    << (String (singleThreadSeconds / seconds, 2) + "x").paddedLeft (' ', 10) << newLine;
+        }
+    }
+
+    const String& getResults() const noexcept       { return results; }
+
+    //==============================================================================
+    void fileDecoded (int /*fileIndex*/, const File& /*file*/, AudioSampleBuffer* samples, double /*sampleRate*/)
+    {
+        numSamplesDecoded += (int64) samples->getNumSamples() * samples->getNumChannels();
+        delete samples;
+    }
+
+    void fileFailed (int /*fileIndex*/, const File& /*file*/)
+    {
+        ++numFilesFailed;
+    }
+
+private:
+    //==============================================================================
+    CoreAudioFormatNew format;
+    Array<File> files;
+    Atomic<int64> numSamplesDecoded;
+    Atomic<int> numFilesFailed;
+    String results;
+
+    /** Decodes all the files on the given number of threads, and returns how many
+        seconds it took. The decoder's threads are started before the clock is.
+    */
+    double decodeAll (int numThreads)
+    {
+        BatchDecoder decoder (format, numThreads);
+        numSamplesDecoded = 0;
+        numFilesFailed = 0;
+
+        const int64 startTicks = Time::getHighResolutionTicks();
+        decoder.decode (files, *this);
+
+        return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (BatchDecodingBenchmark);
+};
+
+//[/MiscUserDefs]
+
+//==============================================================================
+AudioDemoBenchmarkPage::AudioDemoBenchmarkPage ()
+    : explanationLabel (0),
+      conversionButton (0),
+      batchButton (0),
+      resultsBox (0)
+{
+    addAndMakeVisible (explanationLabel = new Label (String::empty,
+                                                     L"Each of these buttons times one of the parts of the audio code that has to be fast, and adds the results to the box below."));
+    explanationLabel->setFont (Font (15.0000f, Font::plain));
+    explanationLabel->setJustificationType (Justification::topLeft);
+    explanationLabel->setEditable (false, false, false);
+    explanationLabel->setColour (TextEditor::textColourId, Colours::black);
+    explanationLabel->setColour (TextEditor::backgroundColourId, Colour (0x0));
+
+    addAndMakeVisible (conversionButton = new TextButton (String::empty));
+    conversionButton->setButtonText (L"Sample Conversion");
+    conversionButton->addListener (this);
+
+    addAndMakeVisible (batchButton = new TextButton (String::empty));
+    batchButton->setButtonText (L"Batch Decoding");
+    batchButton->addListener (this);
+
+    addAndMakeVisible (resultsBox = new TextEditor (String::empty));
+    resultsBox->setMultiLine (true);
+    resultsBox->setReturnKeyStartsNewLine (false);
+    resultsBox->setReadOnly (true);
+    resultsBox->setScrollbarsShown (true);
+    resultsBox->setCaretVisible (false);
+    resultsBox->setPopupMenuEnabled (true);
+    resultsBox->setText (String::empty);
+
+
+    //[UserPreSize]
+    resultsBox->setFont (Font (Font::getDefaultMonospacedFontName(), 13.0f, Font::plain));
+    //[/UserPreSize]
+
+    setSize (600, 400);
+
+
+    //[Constructor] You can add your own custom stuff here..
+    //[/Constructor]
+}
+
+AudioDemoBenchmarkPage::~AudioDemoBenchmarkPage()
+{
+    //[Destructor_pre]. You can add your own custom destruction code here..
+    //[/Destructor_pre]
+
+    deleteAndZero (explanationLabel);
+    deleteAndZero (conversionButton);
+    deleteAndZero (batchButton);
+    deleteAndZero (resultsBox);
+
+
+    //[Destructor]. You can add your own custom destruction code here..
+    //[/Destructor]
+}
+
+//==============================================================================
+void AudioDemoBenchmarkPage::paint (Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+    //[/UserPrePaint]
+
+    g.fillAll (Colours::lightgrey);
+
+    //[UserPaint] Add your own custom painting code here..
+    //[/UserPaint]
+}
+
+void AudioDemoBenchmarkPage::resized()
+{
+    explanationLabel->setBounds (160, 8, getWidth() - 168, 88);
+    conversionButton->setBounds (8, 8, 136, 40);
+    batchButton->setBounds (8, 56, 136, 40);
+    resultsBox->setBounds (8, 104, getWidth() - 16, getHeight() - 112);
+    //[UserResized] Add your own custom resize handling here..
+    //[/UserResized]
+}
+
+void AudioDemoBenchmarkPage::buttonClicked (Button* buttonThatWasClicked)
+{
+    //[UserbuttonClicked_Pre]
+    //[/UserbuttonClicked_Pre]
+
+    if (buttonThatWasClicked == conversionButton)
+    {
+        //[UserButtonCode_conversionButton] -- add your button handler code here..
+        ConversionBenchmark benchmark;
+        benchmark.runThread();
+        addResults (benchmark.getResults());
+        //[/UserButtonCode_conversionButton]
+    }
+    else if (buttonThatWasClicked == batchButton)
+    {
+        //[UserButtonCode_batchButton] -- add your button handler code here..
+        FileChooser chooser ("Choose a folder of audio files to decode...",
+                             File::getSpecialLocation (File::userHomeDirectory));
+
+        if (chooser.browseForDirectory())
+        {
+            BatchDecodingBenchmark benchmark (chooser.getResult());
+
+            if (benchmark.getNumFiles() == 0)
+            {
+                AlertWindow::showMessageBox (AlertWindow::WarningIcon, "Batch Decoding",
+                                             "There aren't any audio files in that folder that can be decoded.");
+            }
+            else
+            {
+                benchmark.runThread();
+                addResults (benchmark.getResults());
+            }
+        }
+        //[/UserButtonCode_batchButton]
+    }
+
+    //[UserbuttonClicked_Post]
+    //[/UserbuttonClicked_Post]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void AudioDemoBenchmarkPage::addResults (const String& results)
+{
+    resultsBox->moveCaretToEnd();
+    resultsBox->insertTextAtCaret (results + newLine);
+}
+//[/MiscUserCode]
+
+
+//==============================================================================
+#if 0
+/*  -- Jucer information section --
+
+    This is where the Jucer puts all of its metadata, so don't change anything in here!
+
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="AudioDemoBenchmarkPage" componentName=""
+                 parentClasses="public Component" constructorParams="" variableInitialisers=""
+                 snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330000013"
+                 fixedSize="0" initialWidth="600" initialHeight="400">
+  <BACKGROUND backgroundColour="ffd3d3d3"/>
+  <LABEL name="" id="5a0e4c2d97b3f168" memberName="explanationLabel" virtualName=""
+         explicitFocusOrder="0" pos="160 8 168M 88" edTextCol="ff000000"
+         edBkgCol="0" labelText="Each of these buttons times one of the parts of the audio code that has to be fast, and adds the results to the box below."
+         editableSingleClick="0" editableDoubleClick="0" focusDiscardsChanges="0"
+         fontname="Default font" fontsize="15" bold="0" italic="0" justification="9"/>
+  <TEXTBUTTON name="" id="e3b7a1f04c6d2985" memberName="conversionButton" virtualName=""
+              explicitFocusOrder="0" pos="8 8 136 40" buttonText="Sample Conversion"
+              connectedEdges="0" needsCallback="1" radioGroupId="0"/>
+  <TEXTBUTTON name="" id="71d2c5e8a094b36f" memberName="batchButton" virtualName=""
+              explicitFocusOrder="0" pos="8 56 136 40" buttonText="Batch Decoding"
+              connectedEdges="0" needsCallback="1" radioGroupId="0"/>
+  <TEXTEDITOR name="" id="9c41f6b2d8e07a35" memberName="resultsBox" virtualName=""
+              explicitFocusOrder="0" pos="8 104 16M 112M" initialText=""
+              multiline="1" retKeyStartsLine="0" readonly="1" scrollbars="1"
+              caret="0" popupmenu="1"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
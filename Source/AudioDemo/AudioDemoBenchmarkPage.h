@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+  This is an automatically generated file created by the Jucer!
+
+  Creation date:  17 Oct 2026 11:52:40pm
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Jucer version: 1.12
+
+  ------------------------------------------------------------------------------
+
+  The Jucer is part of the JUCE library - "Jules' Utility Class Extensions"
+  Copyright 2004-6 by Raw Material Software ltd.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCER_HEADER_AUDIODEMOBENCHMARKPAGE_AUDIODEMOBENCHMARKPAGE_4B8E21D7__
+#define __JUCER_HEADER_AUDIODEMOBENCHMARKPAGE_AUDIODEMOBENCHMARKPAGE_4B8E21D7__
+
+//[Headers]     -- You can add your own extra header files here --
+#include "../../JuceLibraryCode/JuceHeader.h"
+//[/Headers]
+
+
+
+//==============================================================================
+/**
+                                                                    //[Comments]
+    A page of buttons that each time one of the parts of the audio code that has
+    to be fast, and add what they find to a box of results.
+                                                                    //[/Comments]
+*/
+class AudioDemoBenchmarkPage  : public Component,
+                                public ButtonListener
+{
+public:
+    //==============================================================================
+    AudioDemoBenchmarkPage ();
+    ~AudioDemoBenchmarkPage();
+
+    //==============================================================================
+    //[UserMethods]     -- You can add your own custom methods in this section.
+    void addResults (const String& results);
+    //[/UserMethods]
+
+    void paint (Graphics& g);
+    void resized();
+    void buttonClicked (Button* buttonThatWasClicked);
+
+
+
+    //==============================================================================
+    juce_UseDebuggingNewOperator
+
+private:
+    //[UserVariables]   -- You can add your own custom variables in this section.
+    //[/UserVariables]
+
+    //==============================================================================
+    Label* explanationLabel;
+    TextButton* conversionButton;
+    TextButton* batchButton;
+    TextEditor* resultsBox;
+
+
+    //==============================================================================
+    // (prevent copy constructor and operator= being generated..)
+    AudioDemoBenchmarkPage (const AudioDemoBenchmarkPage&);
+    const AudioDemoBenchmarkPage& operator= (const AudioDemoBenchmarkPage&);
+};
+
+
+#endif   // __JUCER_HEADER_AUDIODEMOBENCHMARKPAGE_AUDIODEMOBENCHMARKPAGE_4B8E21D7__
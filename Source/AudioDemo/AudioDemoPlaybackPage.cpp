@@ -23,6 +23,7 @@
 //[/Headers]
 
 #include "AudioDemoPlaybackPage.h"
+#include "../CoreAudioFormat.h"
 
 //[MiscUserDefs] You can add your own user definitions and misc code here...
 class DemoThumbnailComp  : public Component,
@@ -222,6 +223,17 @@ AudioDemoPlaybackPage::AudioDemoPlaybackPage (AudioDeviceManager& deviceManager_
 
 
     //[Constructor] You can add your own custom stuff here..
+    {
+        // the thumbnail and the transport both read whichever file is chosen, so let
+        // them share its decoded blocks. This goes first so that it gets tried first.
+        CoreAudioFormatNew* const coreAudioFormat = new CoreAudioFormatNew();
+        CoreAudioFormatNew::ReaderOptions readerOptions;
+        readerOptions.useSharedBlockCache = true;
+        coreAudioFormat->setReaderOptions (readerOptions);
+
+        formatManager.registerFormat (coreAudioFormat, false);
+    }
+
     formatManager.registerBasicFormats();
 
     directoryList.setDirectory (File::getSpecialLocation (File::userHomeDirectory), true, true);
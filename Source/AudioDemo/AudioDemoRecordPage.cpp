@@ -24,20 +24,33 @@
 
 #include "AudioDemoRecordPage.h"
 #include "../CoreAudioFormat.h"
+#include "../PreRollBuffer.h"
+#include "../RecordingFifo.h"
 
 //[MiscUserDefs] You can add your own user definitions and misc code here...
 
 
 //==============================================================================
 /** A simple class that acts as an AudioIODeviceCallback and writes the
-    incoming audio data to a WAV file.
+    incoming audio data to a file.
+
+    The audio callback never takes a lock. It pushes the incoming samples into a
+    RecordingFifo, which a background thread empties into the writer. The callback
+    finds the current recording through an atomic pointer. When a recording's
+    stopped, it isn't deleted until any callback that might still be using it has
+    returned.
+
+    The callback also keeps the last few seconds of input in a PreRollBuffer all the
+    time, and each recording starts with those, so that nothing's missed by pressing
+    record a moment too late.
 */
 class AudioRecorder  : public AudioIODeviceCallback
 {
 public:
-    AudioRecorder()
+    AudioRecorder (double preRollSeconds_ = 5.0)
         : backgroundThread ("Audio Recorder Thread"),
-          sampleRate (0), activeWriter (0)
+          sampleRate (0), numChannels (0), bitDepth (0),
+          preRollSeconds (preRollSeconds_)
     {
         backgroundThread.startThread();
     }
@@ -52,7 +65,7 @@ public:
     {
         stop();
 
-        if (sampleRate > 0)
+        if (sampleRate > 0 && numChannels > 0)
         {
             // Create an OutputStream to write to our destination file...
             file.deleteFile();
@@ -60,22 +73,32 @@ public:
 
             if (fileStream != 0)
             {
-                // Now create a WAV writer object that writes to our output stream...
+                // Now create a writer object that writes to our output stream...
                 //WavAudioFormat audioFormat;
                 CoreAudioFormatNew audioFormat;
-                AudioFormatWriter* writer = audioFormat.createWriterFor (fileStream, sampleRate, 1, 16, StringPairArray(), 0);
+
+                CoreAudioFormatNew::WriterOptions options;
+                options.fileType = CoreAudioFormatNew::WriterOptions::streamingCafFile;
+                options.outputMethod = CoreAudioFormatNew::WriterOptions::asynchronousOutput;    // (synchronous on Windows)
+                audioFormat.setWriterOptions (options);
+
+                // all of the device's active inputs go into the one interleaved file
+                AudioFormatWriter* writer = audioFormat.createWriterFor (fileStream, sampleRate, (unsigned int) numChannels,
+                                                                         bitDepth >= 24 ? 24 : 16, StringPairArray(), 0);
 
                 if (writer != 0)
                 {
                     fileStream.release(); // (passes responsibility for deleting the stream to the writer object that is now using it)
 
-                    // Now we'll create one of these helper objects which will act as a FIFO buffer, and will
-                    // write the data to disk on our background thread.
-                    threadedWriter = new AudioFormatWriter::ThreadedWriter (writer, backgroundThread, 32768);
+                    // The recording holds the FIFO that the audio callback fills, and empties it into the
+                    // writer on our background thread, after first writing out the pre-roll. The FIFO has
+                    // room for a second of audio, to cover the time that takes.
+                    recording = new Recording (writer, numChannels, jmax (32768, (int) sampleRate),
+                                               preRoll, (int) (preRollSeconds * sampleRate));
+                    backgroundThread.addTimeSliceClient (recording);
 
-                    // And now, swap over our active writer pointer so that the audio callback will start using it..
-                    const ScopedLock sl (writerLock);
-                    activeWriter = threadedWriter;
+                    // And now, publish it so that the audio callback will start using it..
+                    activeRecording = recording;
                 }
             }
         }
@@ -83,42 +106,83 @@ public:
 
     void stop()
     {
-        // First, clear this pointer to stop the audio callback from using our writer object..
-        {
-            const ScopedLock sl (writerLock);
-            activeWriter = 0;
-        }
+        // First, clear this pointer to stop the audio callback from using our recording..
+        activeRecording = nullptr;
+        Atomic<int>::memoryBarrier();
 
-        // Now we can delete the writer object. It's done in this order because the deletion could
+        // ..and wait for any callback that picked it up before then to finish with it.
+        waitForCallbackToReturn();
+
+        // Now we can delete the recording. It's done in this order because the deletion could
         // take a little time while remaining data gets flushed to disk, so it's best to avoid blocking
         // the audio callback while this happens.
-        threadedWriter = 0;
+        if (recording != nullptr)
+        {
+            backgroundThread.removeTimeSliceClient (recording);
+            recording->writeRemainingSamples();
+            recording = nullptr;
+        }
     }
 
     bool isRecording() const
     {
-        return activeWriter != 0;
+        return activeRecording.get() != nullptr;
+    }
+
+    /** Sets the format that the audio callback will deliver. This is normally done by
+        audioDeviceAboutToStart(), but can be called directly to drive the recorder
+        without a device.
+    */
+    void prepareToRecord (double newSampleRate, int newNumChannels, int newBitDepth)
+    {
+        sampleRate = newSampleRate;
+        numChannels = newNumChannels;
+        bitDepth = newBitDepth;
+
+        // The pre-roll has a second to spare beyond the time it keeps, so that a recording
+        // that's just started can copy it out before the audio callback writes over it.
+        const int preRollSize = (int) ((preRollSeconds + 1.0) * sampleRate);
+
+        if (preRoll == nullptr || preRoll->getNumChannels() != jmax (1, numChannels) || preRoll->getCapacity() != preRollSize)
+        {
+            stop();
+            preRoll = new PreRollBuffer (numChannels, preRollSize);
+        }
     }
 
     //==============================================================================
     void audioDeviceAboutToStart (AudioIODevice* device)
     {
-        sampleRate = device->getCurrentSampleRate();
+        prepareToRecord (device->getCurrentSampleRate(),
+                         device->getActiveInputChannels().countNumberOfSetBits(),
+                         device->getCurrentBitDepth());
     }
 
     void audioDeviceStopped()
     {
         sampleRate = 0;
+        numChannels = 0;
     }
 
-    void audioDeviceIOCallback (const float** inputChannelData, int /*numInputChannels*/,
+    void audioDeviceIOCallback (const float** inputChannelData, int numInputChannels,
                                 float** outputChannelData, int numOutputChannels,
                                 int numSamples)
     {
-        const ScopedLock sl (writerLock);
+        ++callbackCount;    // odd while a callback is running
+
+        if (Recording* const r = activeRecording.get())
+        {
+            // the first block that a recording gets marks where its pre-roll ends
+            if (r->firstSamplePosition.get() < 0)
+                r->firstSamplePosition = preRoll != nullptr ? preRoll->getWritePosition() : 0;
+
+            r->fifo.write (inputChannelData, numInputChannels, numSamples);
+        }
+
+        ++callbackCount;
 
-        if (activeWriter != 0)
-            activeWriter->write (inputChannelData, numSamples);
+        if (preRoll != nullptr)
+            preRoll->write (inputChannelData, numInputChannels, numSamples);
 
         // We need to clear the output buffers, in case they're full of junk..
         for (int i = 0; i < numOutputChannels; ++i)
@@ -127,14 +191,261 @@ public:
     }
 
 private:
+    //==============================================================================
+    /** A file being recorded, with the FIFO that feeds it. */
+    struct Recording  : public TimeSliceClient
+    {
+        Recording (AudioFormatWriter* writer_, int numChannels, int fifoSize,
+                   const PreRollBuffer* preRoll_, int numPreRollSamples_)
+            : writer (writer_), fifo (numChannels, fifoSize),
+              firstSamplePosition (-1),
+              preRoll (preRoll_),
+              numPreRollSamples (numPreRollSamples_),
+              isPreRollWritten (preRoll_ == nullptr || numPreRollSamples_ <= 0),
+              preRollChunk (jmax (1, numChannels), 8192)
+        {
+        }
+
+        int useTimeSlice()
+        {
+            // nothing from the FIFO can go in until the pre-roll's been written in front of it
+            if (! writePreRollIfReady())
+                return 10;
+
+            // wait a little longer when there's nothing to write, so the disk gets bigger blocks
+            return fifo.writeTo (*writer, fifo.getNumReady()) > 0 ? 1 : 10;
+        }
+
+        void writeRemainingSamples()
+        {
+            writePreRollIfReady();
+
+            while (fifo.writeTo (*writer, fifo.getNumReady()) > 0)
+            {}
+        }
+
+        ScopedPointer<AudioFormatWriter> writer;
+        RecordingFifo fifo;
+        Atomic<int64> firstSamplePosition;  // set by the audio callback when it first sees the recording
+
+    private:
+        const PreRollBuffer* const preRoll;
+        const int numPreRollSamples;
+        bool isPreRollWritten;
+        AudioSampleBuffer preRollChunk;
+
+        /** Once the audio callback has said where the recording starts, this writes the
+            pre-roll that comes before it. Returns true when it's been written.
+        */
+        bool writePreRollIfReady()
+        {
+            if (isPreRollWritten)
+                return true;
+
+            const int64 end = firstSamplePosition.get();
+
+            if (end < 0)
+                return false;
+
+            int64 position = jmax (preRoll->getOldestPosition(), end - numPreRollSamples);
+
+            while (position < end)
+            {
+                const int numSamples = (int) jmin ((int64) preRollChunk.getNumSamples(), end - position);
+
+                if (preRoll->read (position, preRollChunk, 0, numSamples))
+                {
+                    writer->writeFromAudioSampleBuffer (preRollChunk, 0, numSamples);
+                    position += numSamples;
+                }
+                else
+                {
+                    // the callback has got round to these samples already, so carry on from the oldest ones left
+                    const int64 oldest = preRoll->getOldestPosition();
+
+                    if (oldest <= position)
+                        break;
+
+                    position = oldest;
+                }
+            }
+
+            isPreRollWritten = true;
+            return true;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (Recording);
+    };
+
+    /** Blocks until the audio callback isn't in the middle of a call that could have
+        seen the old value of activeRecording.
+    */
+    void waitForCallbackToReturn() const
+    {
+        const int count = callbackCount.get();
+
+        if ((count & 1) != 0)
+            while (callbackCount.get() == count)
+                Thread::yield();
+    }
+
     TimeSliceThread backgroundThread; // the thread that will write our audio data to disk
-    ScopedPointer<AudioFormatWriter::ThreadedWriter> threadedWriter; // the FIFO used to buffer the incoming data
+    ScopedPointer<Recording> recording; // the current recording, owned by the message thread
     double sampleRate;
+    int numChannels, bitDepth;
+
+    const double preRollSeconds;
+    ScopedPointer<PreRollBuffer> preRoll; // only replaced while the audio callback isn't running
 
-    CriticalSection writerLock;
-    AudioFormatWriter::ThreadedWriter* volatile activeWriter;
+    Atomic<Recording*> activeRecording; // the recording that the audio callback writes to
+    Atomic<int> callbackCount;
 };
 
+//==============================================================================
+/** Drives an AudioRecorder from a thread that stands in for the audio device, while
+    starting and stopping recordings on it as fast as possible, and measures how long
+    the audio callbacks take. None of them should take anything like as long as the
+    block of audio they're handling, however the recordings come and go.
+*/
+class RecorderStressTest  : public ThreadWithProgressWindow
+{
+public:
+    RecorderStressTest()
+        : ThreadWithProgressWindow ("Starting and stopping recordings...", true, true),
+          audioThread (recorder)
+    {
+    }
+
+    void run()
+    {
+        const File folder (File::getSpecialLocation (File::tempDirectory)
+                             .getNonexistentChildFile ("Recorder Stress Test", String::empty, false));
+        folder.createDirectory();
+
+        recorder.prepareToRecord (sampleRate, numChannels, 24);
+        audioThread.startThread (9);
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        Random random;
+        int numRecordings = 0;
+
+        for (;;)
+        {
+            const uint32 elapsed = Time::getMillisecondCounter() - startTime;
+
+            if (elapsed >= durationMs || threadShouldExit())
+                break;
+
+            setProgress (elapsed / (double) durationMs);
+
+            const File file (folder.getChildFile ("Recording " + String (numRecordings) + ".caf"));
+            recorder.startRecording (file);
+            Thread::sleep (random.nextInt (20));
+            recorder.stop();
+            file.deleteFile();
+
+            ++numRecordings;
+        }
+
+        audioThread.stopThread (5000);
+        recorder.audioDeviceStopped();
+        folder.deleteRecursively();
+
+        const double blockMs = 1000.0 * blockSize / sampleRate;
+        const int numCallbacks = audioThread.numCallbacks;
+
+        results << "Started and stopped " << numRecordings << " recordings during " << numCallbacks
+                << " audio callbacks of " << (int) blockSize << " samples (" << String (blockMs, 2) << " ms each)." << newLine << newLine
+                << "Average callback: " << String (numCallbacks > 0 ? audioThread.totalMs / numCallbacks : 0.0, 4) << " ms" << newLine
+                << "Slowest callback: " << String (audioThread.worstMs, 4) << " ms" << newLine
+                << "Callbacks that took longer than their block: " << audioThread.numOverruns;
+    }
+
+    const String& getResults() const noexcept       { return results; }
+
+private:
+    //==============================================================================
+    enum { numChannels = 2, blockSize = 256, durationMs = 10000 };
+    static const double sampleRate;
+
+    /** Calls the recorder's audio callback with a block of noise every time a real
+        device would, timing each call.
+    */
+    class SimulatedAudioThread  : public Thread
+    {
+    public:
+        SimulatedAudioThread (AudioRecorder& recorder_)
+            : Thread ("Simulated audio device"),
+              numCallbacks (0), numOverruns (0),
+              totalMs (0), worstMs (0),
+              recorder (recorder_),
+              input (numChannels, blockSize),
+              output (numChannels, blockSize)
+        {
+            Random random (1);
+
+            for (int i = 0; i < numChannels; ++i)
+                for (int j = 0; j < blockSize; ++j)
+                    *input.getSampleData (i, j) = random.nextFloat() * 0.5f - 0.25f;
+        }
+
+        ~SimulatedAudioThread()
+        {
+            stopThread (5000);
+        }
+
+        void run()
+        {
+            const double blockMs = 1000.0 * blockSize / sampleRate;
+            double nextCallbackTime = Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                const int64 startTicks = Time::getHighResolutionTicks();
+
+                recorder.audioDeviceIOCallback ((const float**) input.getArrayOfChannels(), numChannels,
+                                                output.getArrayOfChannels(), numChannels, blockSize);
+
+                const double ms = 1000.0 * Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+                ++numCallbacks;
+                totalMs += ms;
+                worstMs = jmax (worstMs, ms);
+
+                if (ms > blockMs)
+                    ++numOverruns;
+
+                // keep to the device's schedule, rather than running flat out
+                nextCallbackTime += blockMs;
+                const double msToWait = nextCallbackTime - Time::getMillisecondCounterHiRes();
+
+                if (msToWait >= 1.0)
+                    wait ((int) msToWait);
+                else if (msToWait < -blockMs)
+                    nextCallbackTime = Time::getMillisecondCounterHiRes();
+            }
+        }
+
+        // (only read once the thread has stopped)
+        int numCallbacks, numOverruns;
+        double totalMs, worstMs;
+
+    private:
+        AudioRecorder& recorder;
+        AudioSampleBuffer input, output;
+
+        JUCE_DECLARE_NON_COPYABLE (SimulatedAudioThread);
+    };
+
+    AudioRecorder recorder;
+    SimulatedAudioThread audioThread;
+    String results;
+
+    JUCE_DECLARE_NON_COPYABLE (RecorderStressTest);
+};
+
+const double RecorderStressTest::sampleRate = 44100.0;
+
 //[/MiscUserDefs]
 
 //==============================================================================
@@ -142,7 +453,8 @@ AudioDemoRecordPage::AudioDemoRecordPage (AudioDeviceManager& deviceManager_)
     : deviceManager (deviceManager_),
       liveAudioDisplayComp (0),
       explanationLabel (0),
-      recordButton (0)
+      recordButton (0),
+      stressTestButton (0)
 {
     addAndMakeVisible (liveAudioDisplayComp = new LiveAudioInputDisplayComp());
 
@@ -160,6 +472,10 @@ AudioDemoRecordPage::AudioDemoRecordPage (AudioDeviceManager& deviceManager_)
     recordButton->setColour (TextButton::buttonColourId, Colour (0xffff5c5c));
     recordButton->setColour (TextButton::textColourOnId, Colours::black);
 
+    addAndMakeVisible (stressTestButton = new TextButton (String::empty));
+    stressTestButton->setButtonText (L"Stress Test");
+    stressTestButton->addListener (this);
+
 
     //[UserPreSize]
     //[/UserPreSize]
@@ -185,6 +501,7 @@ AudioDemoRecordPage::~AudioDemoRecordPage()
     deleteAndZero (liveAudioDisplayComp);
     deleteAndZero (explanationLabel);
     deleteAndZero (recordButton);
+    deleteAndZero (stressTestButton);
 
 
     //[Destructor]. You can add your own custom destruction code here..
@@ -208,6 +525,7 @@ void AudioDemoRecordPage::resized()
     liveAudioDisplayComp->setBounds (8, 8, getWidth() - 16, 64);
     explanationLabel->setBounds (160, 88, getWidth() - 169, 216);
     recordButton->setBounds (8, 88, 136, 40);
+    stressTestButton->setBounds (8, 136, 136, 40);
     //[UserResized] Add your own custom resize handling here..
     //[/UserResized]
 }
@@ -239,6 +557,15 @@ void AudioDemoRecordPage::buttonClicked (Button* buttonThatWasClicked)
 
         //[/UserButtonCode_recordButton]
     }
+    else if (buttonThatWasClicked == stressTestButton)
+    {
+        //[UserButtonCode_stressTestButton] -- add your button handler code here..
+        RecorderStressTest stressTest;
+
+        if (stressTest.runThread())
+            AlertWindow::showMessageBox (AlertWindow::InfoIcon, "Recorder Stress Test", stressTest.getResults());
+        //[/UserButtonCode_stressTestButton]
+    }
 
     //[UserbuttonClicked_Post]
     //[/UserbuttonClicked_Post]
@@ -287,6 +614,9 @@ BEGIN_JUCER_METADATA
               explicitFocusOrder="0" pos="8 88 136 40" bgColOff="ffff5c5c"
               textCol="ff000000" buttonText="Record" connectedEdges="0" needsCallback="1"
               radioGroupId="0"/>
+  <TEXTBUTTON name="" id="8f3e61b0d27ac594" memberName="stressTestButton" virtualName=""
+              explicitFocusOrder="0" pos="8 136 136 40" buttonText="Stress Test"
+              connectedEdges="0" needsCallback="1" radioGroupId="0"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
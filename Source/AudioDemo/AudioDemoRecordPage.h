@@ -70,6 +70,7 @@ private:
     LiveAudioInputDisplayComp* liveAudioDisplayComp;
     Label* explanationLabel;
     TextButton* recordButton;
+    TextButton* stressTestButton;
 
 
     //==============================================================================
@@ -26,6 +26,7 @@
 #include "AudioDemoSetupPage.h"
 #include "AudioDemoPlaybackPage.h"
 #include "AudioDemoRecordPage.h"
+#include "AudioDemoBenchmarkPage.h"
 
 
 //[MiscUserDefs] You can add your own user definitions and misc code here...
@@ -119,6 +120,7 @@ AudioDemoTabComponent::AudioDemoTabComponent ()
 //    tabbedComponent->addTab (L"Synth Playback", Colours::lightgrey, new AudioDemoSynthPage (deviceManager), true);
 //    tabbedComponent->addTab (L"Latency Test", Colours::lightgrey, new AudioDemoLatencyPage (deviceManager), true);
     tabbedComponent->addTab (L"Recording", Colours::lightgrey, new AudioDemoRecordPage (deviceManager), true);
+    tabbedComponent->addTab (L"Benchmarks", Colours::lightgrey, new AudioDemoBenchmarkPage(), true);
     tabbedComponent->setCurrentTabIndex (0);
 
 
@@ -202,6 +204,8 @@ BEGIN_JUCER_METADATA
          constructorParams="deviceManager" jucerComponentFile="AudioDemoLatencyPage.cpp"/>
     <TAB name="Recording" colour="ffd3d3d3" useJucerComp="1" contentClassName=""
          constructorParams="deviceManager" jucerComponentFile="AudioDemoRecordPage.cpp"/>
+    <TAB name="Benchmarks" colour="ffd3d3d3" useJucerComp="1" contentClassName=""
+         constructorParams="" jucerComponentFile="AudioDemoBenchmarkPage.cpp"/>
   </TABBEDCOMPONENT>
 </JUCER_COMPONENT>
 
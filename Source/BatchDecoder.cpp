@@ -0,0 +1,341 @@
+/*
+  ==============================================================================
+
+    BatchDecoder.cpp
+    Created: 17 Oct 2026 8:21:44pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "BatchDecoder.h"
+
+//==============================================================================
+/** The state shared by the workers that are decoding one list of files. */
+class BatchDecoder::Batch
+{
+public:
+    Batch (const Array<File>& files_, int numQueues, int64 maxBytesInFlight_)
+        : files (files_),
+          callback (nullptr),
+          destBuffers (nullptr),
+          sampleRates (nullptr),
+          bytesInFlight (0),
+          maxBytesInFlight (maxBytesInFlight_)
+    {
+        // each worker starts off with an even share of the list
+        const int numFiles = files.size();
+
+        for (int i = 0; i < numQueues; ++i)
+        {
+            Queue* const queue = queues.add (new Queue());
+            queue->next = (int) ((int64) numFiles * i / numQueues);
+            queue->end  = (int) ((int64) numFiles * (i + 1) / numQueues);
+        }
+    }
+
+    //==============================================================================
+    /** Finds the next file for a worker, stealing from the others if its own queue
+        has run dry. Returns false when there's nothing left anywhere.
+    */
+    bool getNextFile (int queueIndex, int& fileIndex)
+    {
+        Queue& own = *queues.getUnchecked (queueIndex);
+
+        {
+            const SpinLock::ScopedLockType sl (own.lock);
+
+            if (own.next < own.end)
+            {
+                fileIndex = own.next++;
+                return true;
+            }
+        }
+
+        for (;;)
+        {
+            Queue* const victim = findBusiestQueue();
+
+            if (victim == nullptr)
+                return false;
+
+            int start, end;
+
+            {
+                const SpinLock::ScopedLockType sl (victim->lock);
+                const int numLeft = victim->end - victim->next;
+
+                if (numLeft <= 0)
+                    continue;   // someone else has emptied it since we looked
+
+                // take the back half, which is furthest from where the victim is working
+                end = victim->end;
+                start = end - (numLeft + 1) / 2;
+                victim->end = start;
+            }
+
+            // the locks are never nested, so that two workers stealing from each other can't deadlock
+            const SpinLock::ScopedLockType sl (own.lock);
+            own.next = start + 1;
+            own.end = end;
+            fileIndex = start;
+            return true;
+        }
+    }
+
+    //==============================================================================
+    /** Waits until there's room in the memory budget for a decoded file. */
+    void reserve (int64 numBytes)
+    {
+        for (;;)
+        {
+            {
+                const ScopedLock sl (budgetLock);
+
+                if (bytesInFlight == 0 || bytesInFlight + numBytes <= maxBytesInFlight)
+                {
+                    bytesInFlight += numBytes;
+                    return;
+                }
+            }
+
+            budgetFreed.wait (100);
+        }
+    }
+
+    void release (int64 numBytes)
+    {
+        {
+            const ScopedLock sl (budgetLock);
+            bytesInFlight -= numBytes;
+        }
+
+        budgetFreed.signal();
+    }
+
+    //==============================================================================
+    void fileSucceeded (int fileIndex, double sampleRate)
+    {
+        if (sampleRates != nullptr)
+            sampleRates->set (fileIndex, sampleRate);
+
+        ++numDecoded;
+    }
+
+    void fileFailed (int fileIndex)
+    {
+        if (sampleRates != nullptr)
+            sampleRates->set (fileIndex, 0.0);
+
+        if (callback != nullptr)
+            callback->fileFailed (fileIndex, files.getReference (fileIndex));
+    }
+
+    //==============================================================================
+    const Array<File>& files;
+    Callback* callback;
+    const Array<AudioSampleBuffer*>* destBuffers;
+    Array<double>* sampleRates;     // sized up front, so the workers only ever set elements
+    Atomic<int> numDecoded;
+
+private:
+    struct Queue
+    {
+        SpinLock lock;
+        int next, end;      // the range of file indexes that are still to do
+    };
+
+    OwnedArray<Queue> queues;
+
+    CriticalSection budgetLock;
+    WaitableEvent budgetFreed;
+    int64 bytesInFlight;
+    const int64 maxBytesInFlight;
+
+    Queue* findBusiestQueue()
+    {
+        Queue* busiest = nullptr;
+        int mostLeft = 0;
+
+        for (int i = queues.size(); --i >= 0;)
+        {
+            Queue* const queue = queues.getUnchecked (i);
+            const SpinLock::ScopedLockType sl (queue->lock);
+            const int numLeft = queue->end - queue->next;
+
+            if (numLeft > mostLeft)
+            {
+                busiest = queue;
+                mostLeft = numLeft;
+            }
+        }
+
+        return busiest;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Batch);
+};
+
+//==============================================================================
+/** Decodes files from its queue, and then from everyone else's, until they've all been done. */
+class BatchDecoder::Worker  : public ThreadPoolJob
+{
+public:
+    Worker (AudioFormat& format_, Batch& batch_, int queueIndex_)
+        : ThreadPoolJob ("Batch decoder"),
+          format (format_), batch (batch_), queueIndex (queueIndex_)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        int fileIndex;
+
+        while (! shouldExit() && batch.getNextFile (queueIndex, fileIndex))
+            decodeFile (fileIndex);
+
+        return jobHasFinished;
+    }
+
+private:
+    AudioFormat& format;
+    Batch& batch;
+    const int queueIndex;
+
+    void decodeFile (int fileIndex)
+    {
+        const File& file = batch.files.getReference (fileIndex);
+        ScopedPointer<AudioFormatReader> reader;
+
+        if (FileInputStream* const in = file.createInputStream())
+            reader = format.createReaderFor (in, true);
+
+        if (reader == nullptr || reader->numChannels == 0 || reader->lengthInSamples > 0x7fffffff)
+        {
+            if (batch.destBuffers != nullptr)
+                batch.destBuffers->getUnchecked (fileIndex)->setSize (0, 0);
+
+            batch.fileFailed (fileIndex);
+            return;
+        }
+
+        if (batch.destBuffers != nullptr)
+        {
+            AudioSampleBuffer& dest = *batch.destBuffers->getUnchecked (fileIndex);
+
+            if (readWholeFile (*reader, dest))
+            {
+                batch.fileSucceeded (fileIndex, reader->sampleRate);
+            }
+            else
+            {
+                dest.setSize (0, 0);
+                batch.fileFailed (fileIndex);
+            }
+
+            return;
+        }
+
+        const int64 numBytes = (int64) reader->numChannels * reader->lengthInSamples * (int64) sizeof (float);
+        batch.reserve (numBytes);
+
+        ScopedPointer<AudioSampleBuffer> samples (new AudioSampleBuffer ((int) reader->numChannels, (int) reader->lengthInSamples));
+
+        if (readWholeFile (*reader, *samples))
+        {
+            batch.fileSucceeded (fileIndex, reader->sampleRate);
+            batch.callback->fileDecoded (fileIndex, file, samples.release(), reader->sampleRate);
+        }
+        else
+        {
+            batch.fileFailed (fileIndex);
+        }
+
+        batch.release (numBytes);
+    }
+
+    static bool readWholeFile (AudioFormatReader& reader, AudioSampleBuffer& buffer)
+    {
+        const int numChannels = (int) reader.numChannels;
+        const int numSamples = (int) reader.lengthInSamples;
+
+        buffer.setSize (numChannels, numSamples);
+
+        if (! reader.read (reinterpret_cast<int* const*> (buffer.getArrayOfChannels()), numChannels, 0, numSamples, false))
+            return false;
+
+        // integer readers give out left-justified ints, which are turned into floats in place
+        if (! reader.usesFloatingPointData)
+        {
+            const float scale = 1.0f / (float) 0x7fffffff;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                float* const data = buffer.getSampleData (i);
+                const int* const ints = reinterpret_cast<const int*> (data);
+
+                for (int j = 0; j < numSamples; ++j)
+                    data[j] = scale * (float) ints[j];
+            }
+        }
+
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Worker);
+};
+
+//==============================================================================
+BatchDecoder::BatchDecoder (AudioFormat& format_, int numThreads_, int64 maxBytesInFlight_)
+    : format (format_),
+      numThreads (numThreads_ > 0 ? numThreads_ : jmax (1, SystemStats::getNumCpus())),
+      maxBytesInFlight (maxBytesInFlight_),
+      pool (numThreads)
+{
+}
+
+BatchDecoder::~BatchDecoder()
+{
+}
+
+int BatchDecoder::decode (const Array<File>& files, Callback& callback)
+{
+    Batch batch (files, numThreads, maxBytesInFlight);
+    batch.callback = &callback;
+
+    return run (batch);
+}
+
+int BatchDecoder::decode (const Array<File>& files, const Array<AudioSampleBuffer*>& destBuffers,
+                          Array<double>* sampleRates)
+{
+    jassert (destBuffers.size() == files.size());
+
+    if (destBuffers.size() < files.size())
+        return 0;
+
+    if (sampleRates != nullptr)
+    {
+        sampleRates->clearQuick();
+        sampleRates->insertMultiple (0, 0.0, files.size());
+    }
+
+    Batch batch (files, numThreads, maxBytesInFlight);
+    batch.destBuffers = &destBuffers;
+    batch.sampleRates = sampleRates;
+
+    return run (batch);
+}
+
+int BatchDecoder::run (Batch& batch)
+{
+    OwnedArray<Worker> workers;
+
+    for (int i = 0; i < numThreads; ++i)
+        pool.addJob (workers.add (new Worker (format, batch, i)));
+
+    for (int i = workers.size(); --i >= 0;)
+        pool.waitForJobToFinish (workers.getUnchecked (i), -1);
+
+    return batch.numDecoded.get();
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    BatchDecoder.h
+    Created: 17 Oct 2026 8:21:44pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __BATCHDECODER_H_5E17B08D__
+#define __BATCHDECODER_H_5E17B08D__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    Decodes a whole list of files at once, spreading them across several threads.
+
+    This is for loading lots of short files, e.g. a folder of samples. Each thread
+    starts off with its own share of the list, and any that runs out of files takes
+    half of what's left from whichever thread has the most still to do, so a few
+    long files don't leave the other threads sitting idle.
+
+    The files can either be decoded into buffers that the caller supplies, or handed
+    to a Callback one at a time as they're finished. With a Callback, the decoded
+    files that are waiting to be handed over are limited to a set amount of memory.
+
+    @see CoreAudioFormatNew
+*/
+class BatchDecoder
+{
+public:
+    //==============================================================================
+    /** Creates a decoder that reads files with the given format.
+
+        @param format           the format to create readers with. This has to stay
+                                alive as long as the decoder, and have a
+                                createReaderFor() that's safe to call from several
+                                threads at once, as CoreAudioFormatNew's is
+        @param numThreads       the number of threads to decode on, or 0 for one per CPU
+        @param maxBytesInFlight with a Callback, the most memory that decoded files
+                                may take up before they've been handed over. A file
+                                that's bigger than this on its own is still decoded,
+                                but only when nothing else is in flight
+    */
+    BatchDecoder (AudioFormat& format, int numThreads = 0, int64 maxBytesInFlight = 256 * 1024 * 1024);
+
+    /** Destructor. */
+    ~BatchDecoder();
+
+    //==============================================================================
+    /** Receives the files as they're decoded by decode(). */
+    class Callback
+    {
+    public:
+        virtual ~Callback() {}
+
+        /** Called with the samples of a file once they've all been decoded.
+
+            This is called on one of the decoding threads, so it has to be thread-safe.
+            The callback takes ownership of the buffer, and must delete it.
+        */
+        virtual void fileDecoded (int fileIndex, const File& file, AudioSampleBuffer* samples, double sampleRate) = 0;
+
+        /** Called on one of the decoding threads for files that couldn't be read. */
+        virtual void fileFailed (int /*fileIndex*/, const File& /*file*/) {}
+    };
+
+    /** Decodes some files, passing each one to the callback when it's ready.
+        This doesn't return until all of them have been dealt with.
+        @returns the number of files that were decoded
+    */
+    int decode (const Array<File>& files, Callback& callback);
+
+    /** Decodes some files into buffers supplied by the caller.
+
+        Each buffer is resized to fit its file's channels and length. Any that can't
+        be read are left with no channels. If sampleRates isn't null, it's filled in
+        with the files' rates, with 0 for the failures. This doesn't return until all
+        the files have been decoded.
+
+        @returns the number of files that were decoded
+    */
+    int decode (const Array<File>& files, const Array<AudioSampleBuffer*>& destBuffers,
+                Array<double>* sampleRates = nullptr);
+
+    /** Returns the number of threads that files are decoded on. */
+    int getNumThreads() const noexcept          { return numThreads; }
+
+private:
+    //==============================================================================
+    class Batch;
+    class Worker;
+
+    AudioFormat& format;
+    const int numThreads;
+    const int64 maxBytesInFlight;
+    ThreadPool pool;
+
+    int run (Batch& batch);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchDecoder);
+};
+
+
+#endif  // __BATCHDECODER_H_5E17B08D__
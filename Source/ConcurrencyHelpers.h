@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    ConcurrencyHelpers.h
+    Created: 17 Oct 2026 7:12:41pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __CONCURRENCYHELPERS_H_5C27E0B3__
+#define __CONCURRENCYHELPERS_H_5C27E0B3__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    An object that's shared by everything in the app, created the first time it's asked for.
+
+    A function-level static would do the same job, but Visual Studio 2010 doesn't make
+    their construction thread-safe, and the objects kept in these are first asked for
+    by readers and writers that can be opened on several threads at once. This guards
+    the creation with a lock instead. Declare one at file scope, e.g.
+
+    @code
+    ThreadPool* createSharedPool()   { return new ThreadPool (2); }
+    LazySingleton<ThreadPool> sharedPool (createSharedPool);
+    @endcode
+*/
+template <class ObjectType>
+class LazySingleton
+{
+public:
+    typedef ObjectType* (*CreateFunction)();
+
+    explicit LazySingleton (CreateFunction createFunction_) noexcept
+        : createFunction (createFunction_)
+    {
+    }
+
+    /** Returns the object, creating it if this is the first call. */
+    ObjectType& get()
+    {
+        const ScopedLock sl (lock);
+
+        if (object == nullptr)
+            object = createFunction();
+
+        return *object;
+    }
+
+private:
+    const CreateFunction createFunction;
+    CriticalSection lock;
+    ScopedPointer<ObjectType> object;
+
+    JUCE_DECLARE_NON_COPYABLE (LazySingleton);
+};
+
+//==============================================================================
+/**
+    Puts a job that drains its own queue back onto a pool, if it isn't already on it.
+
+    This is for jobs that keep pulling work off a queue until it's empty and then
+    return ThreadPoolJob::jobHasFinished. The caller must hold the lock that guards
+    the queue, and the job must clear isQueuedOnPool under that same lock just before
+    it returns, without taking the lock again afterwards.
+
+    If the job has only just emptied the queue it may still be on the pool, so this
+    waits for it to get off before adding it again. Waiting while holding the lock
+    can't deadlock: once the job has cleared the flag it has nothing left to do but
+    return, and it never needs the lock to do that.
+*/
+inline void requeueDrainingJob (ThreadPool& pool, ThreadPoolJob* job, bool& isQueuedOnPool)
+{
+    if (! isQueuedOnPool)
+    {
+        pool.waitForJobToFinish (job, -1);
+        isQueuedOnPool = true;
+        pool.addJob (job);
+    }
+}
+
+
+#endif   // __CONCURRENCYHELPERS_H_5C27E0B3__
@@ -9,9 +9,19 @@
 */
 
 #include "CoreAudioFormat.h"
-#include <AudioToolbox/AudioToolbox.h>
 
 #if JUCE_MAC || JUCE_IOS
+ #include <AudioToolbox/AudioToolbox.h>
+#else
+ #include "PortableAudioToolbox.h"
+#endif
+
+#include "ConcurrencyHelpers.h"
+#include "DecodedBlockCache.h"
+#include "PositionalOutput.h"
+#include "ReadAheadInput.h"
+#include "SampleConversion.h"
+
 #define CoreAudioFormat CoreAudioFormatNew
 
 //==============================================================================
@@ -19,62 +29,595 @@ namespace
 {
     const char* const coreAudioFormatName = "CoreAudio supported file";
 
-    StringArray findFileExtensionsForCoreAudioCodecs()
+    const int readAheadBlockSize = 64 * 1024;
+    const int numReadAheadCachedBlocks = 4;
+
+    // readers of the same file have to agree on this, so that they can share blocks
+    const int framesPerCachedBlock = 16384;
+
+    //==============================================================================
+    /** The file types, extensions and formats that the system's codecs can handle.
+
+        Asking the system for these is slow, so it's only done once, the first time a
+        format or writer needs them. Nothing changes after that, so the registry can be
+        read from any thread.
+    */
+    class CodecRegistry
     {
-        StringArray extensionsArray;
-        CFMutableArrayRef extensions = CFArrayCreateMutable (0, 0, 0);
-        UInt32 sizeOfArray = sizeof (CFMutableArrayRef);
+    public:
+        static const CodecRegistry& getInstance()
+        {
+            return instance.get();
+        }
+
+        bool canRead (AudioFileTypeID type) const       { return readableTypes.contains (type); }
+        bool canWrite (AudioFileTypeID type) const      { return writableTypes.contains (type); }
+
+        StringArray extensions;
+        Array<AudioFileTypeID> readableTypes, writableTypes;
+        Array<int> sampleRates, bitDepths;
+
+    private:
+        static LazySingleton<CodecRegistry> instance;
+
+        static CodecRegistry* create()      { return new CodecRegistry(); }
+
+        CodecRegistry()
+            : extensions (findExtensions()),
+              readableTypes (findTypes (kAudioFileGlobalInfo_ReadableTypes)),
+              writableTypes (findTypes (kAudioFileGlobalInfo_WritableTypes))
+        {
+            // linear PCM can be written at any rate, so these are just the common ones
+            const int rates[] = { 8000, 11025, 12000, 16000, 22050, 32000, 44100,
+                                  48000, 88200, 96000, 176400, 192000 };
+            sampleRates.addArray (rates, numElementsInArray (rates));
+
+            // both kinds of writer can do all of these; 64 bits means doubles, see createWriterFor()
+            const int depths[] = { 8, 16, 24, 32, 64 };
+            bitDepths.addArray (depths, numElementsInArray (depths));
+        }
+
+        static StringArray findExtensions()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            StringArray extensionsArray;
+            CFMutableArrayRef extensions = CFArrayCreateMutable (0, 0, 0);
+            UInt32 sizeOfArray = sizeof (CFMutableArrayRef);
+
+            if (AudioFileGetGlobalInfo (kAudioFileGlobalInfo_AllExtensions, 0, 0, &sizeOfArray, &extensions) == noErr)
+            {
+                const CFIndex numValues = CFArrayGetCount (extensions);
+
+                for (CFIndex i = 0; i < numValues; ++i)
+                    extensionsArray.add ("." + String::fromCFString ((CFStringRef) CFArrayGetValueAtIndex (extensions, i)));
+            }
+
+            CFRelease (extensions);
+            return extensionsArray;
+           #else
+            return PortableAudioToolbox::getAllExtensions();
+           #endif
+        }
 
-        if (AudioFileGetGlobalInfo (kAudioFileGlobalInfo_AllExtensions, 0, 0, &sizeOfArray, &extensions) == noErr)
+        static Array<AudioFileTypeID> findTypes (AudioFilePropertyID propertyID)
         {
-            const CFIndex numValues = CFArrayGetCount (extensions);
+            Array<AudioFileTypeID> types;
+            UInt32 size = 0;
 
-            for (CFIndex i = 0; i < numValues; ++i)
-                extensionsArray.add ("." + String::fromCFString ((CFStringRef) CFArrayGetValueAtIndex (extensions, i)));
+            if (AudioFileGetGlobalInfoSize (propertyID, 0, NULL, &size) == noErr && size > 0)
+            {
+                const int numTypes = (int) (size / sizeof (AudioFileTypeID));
+                HeapBlock<AudioFileTypeID> fileTypes ((size_t) numTypes);
+
+                if (AudioFileGetGlobalInfo (propertyID, 0, NULL, &size, fileTypes) == noErr)
+                    types.addArray (fileTypes.getData(), (int) (size / sizeof (AudioFileTypeID)));
+            }
+
+            return types;
         }
 
-        CFRelease (extensions);
-        return extensionsArray;
+        JUCE_DECLARE_NON_COPYABLE (CodecRegistry);
+    };
+
+    LazySingleton<CodecRegistry> CodecRegistry::instance (CodecRegistry::create);
+
+    /** Creates the PositionalOutput that a writer should use, set up as the options ask.
+        If the options give an expected duration, space for that much audio is reserved.
+    */
+    PositionalOutput* createDestinationFor (OutputStream& stream, const CoreAudioFormat::WriterOptions& options,
+                                            double sampleRate, int bytesPerFrame)
+    {
+        PositionalOutput* destination = nullptr;
+
+        if (options.outputMethod == CoreAudioFormat::WriterOptions::memoryMappedOutput)
+            destination = PositionalOutput::createMemoryMappedFor (stream);
+        else if (options.outputMethod == CoreAudioFormat::WriterOptions::asynchronousOutput)
+            destination = PositionalOutput::createAsynchronousFor (stream);
+        else if (options.outputMethod == CoreAudioFormat::WriterOptions::directOutput)
+            destination = PositionalOutput::createDirectFor (stream);
+
+        if (destination == nullptr)
+            destination = PositionalOutput::createFor (stream);
+
+        if (options.growthPolicy == CoreAudioFormat::WriterOptions::allocateSpace)
+            destination->setGrowthMode (PositionalOutput::allocateSpace);
+
+        if (options.expectedDurationSeconds > 0)
+        {
+            const int64 headerAllowance = 4096;
+            destination->reserve (destination->getSize() + headerAllowance
+                                    + (int64) (options.expectedDurationSeconds * sampleRate) * bytesPerFrame);
+        }
+
+        return destination;
     }
-    
-    StringArray findWritableTypes()
+
+    /** Flushes a writer's destination as often as its options' durabilityPolicy asks. */
+    class DurabilityTracker
     {
-        StringArray extensionsArray;
-        
-        UInt32 size;
-        UInt32* fileTypes = NULL;
-        
-        OSStatus status = AudioFileGetGlobalInfoSize (kAudioFileGlobalInfo_WritableTypes, 0, NULL, &size);
-        if (status == noErr)
+    public:
+        DurabilityTracker (const CoreAudioFormat::WriterOptions& options) noexcept
+            : policy (options.durabilityPolicy),
+              flushIntervalBytes (options.flushIntervalBytes),
+              bytesSinceFlush (0)
         {
-            const int numFileFormats = size / sizeof (UInt32);
-            fileTypes = new UInt32[numFileFormats];
-            
-            status = AudioFileGetGlobalInfo (kAudioFileGlobalInfo_WritableTypes, 0, NULL, &size, fileTypes);
-            if (status == noErr)
+        }
+
+        /** Keeps track of how much hasn't been flushed, and flushes it if the options ask for that. */
+        void noteBytesWritten (PositionalOutput& destination, int64 numBytes)
+        {
+            bytesSinceFlush += numBytes;
+
+            if (policy == CoreAudioFormat::WriterOptions::flushAfterEveryWrite
+                 || (policy == CoreAudioFormat::WriterOptions::flushAfterInterval
+                      && bytesSinceFlush >= flushIntervalBytes))
             {
-                for (int i = 0; i < numFileFormats; ++i)
+                destination.flush();
+                bytesSinceFlush = 0;
+            }
+        }
+
+    private:
+        const CoreAudioFormat::WriterOptions::DurabilityPolicy policy;
+        const int64 flushIntervalBytes;
+        int64 bytesSinceFlush;
+
+        JUCE_DECLARE_NON_COPYABLE (DurabilityTracker);
+    };
+
+    /** Gathers up the small blocks that a writer is given, like the ones that come from
+        an audio callback, and passes them on in bigger ones, so that whatever's beneath
+        it sees fewer writes. Blocks that are already big enough go straight through.
+    */
+    class StagingBuffer
+    {
+    public:
+        /** Whatever the blocks are passed on to. */
+        class Target
+        {
+        public:
+            virtual ~Target() {}
+
+            /** Writes a block of samples, returning false if it fails. */
+            virtual bool writeBlock (const float** channels, int numSamples) = 0;
+        };
+
+        /** Creates a buffer that gathers blocks of up to size samples. With a size of 0,
+            everything goes straight through.
+        */
+        StagingBuffer (Target& target_, int numChannels_, int size_)
+            : target (target_),
+              numChannels (numChannels_),
+              size (jmax (0, size_)),
+              buffer (jmax (1, numChannels_), jmax (1, size_)),
+              numStaged (0)
+        {
+        }
+
+        /** Adds some samples, passing on each block as it fills up. The channel list ends
+            at the first null pointer, and anything after that is silent.
+        */
+        bool write (const float** channels, int numSamples)
+        {
+            if (numStaged == 0 && numSamples >= size)
+                return target.writeBlock (channels, numSamples);
+
+            for (int startSample = 0; startSample < numSamples;)
+            {
+                const int numToCopy = jmin (numSamples - startSample, size - numStaged);
+                bool isChannelMissing = false;
+
+                for (int i = 0; i < numChannels; ++i)
                 {
-                    String typeId;
-                    char* id = (char*) &fileTypes[i];
-                    typeId << id[3] << id[2] << id[1] << id[0];
-                    extensionsArray.add (typeId);
+                    float* const dest = buffer.getSampleData (i, numStaged);
+                    isChannelMissing = isChannelMissing || channels[i] == nullptr;
+
+                    if (isChannelMissing)
+                        zeromem (dest, sizeof (float) * (size_t) numToCopy);
+                    else
+                        memcpy (dest, channels[i] + startSample, sizeof (float) * (size_t) numToCopy);
                 }
+
+                numStaged += numToCopy;
+                startSample += numToCopy;
+
+                if (numStaged == size && ! flush())
+                    return false;
             }
+
+            return true;
         }
-        
-        return extensionsArray;
+
+        /** Passes on any samples that are waiting in the buffer. */
+        bool flush()
+        {
+            if (numStaged == 0)
+                return true;
+
+            const int numToWrite = numStaged;
+            numStaged = 0;
+            return target.writeBlock (const_cast<const float**> (buffer.getArrayOfChannels()), numToWrite);
+        }
+
+    private:
+        Target& target;
+        const int numChannels, size;
+        AudioSampleBuffer buffer;
+        int numStaged;
+
+        JUCE_DECLARE_NON_COPYABLE (StagingBuffer);
+    };
+
+    /** Fills a list with a writer's source channels. The channel list that write() is given
+        ends at the first null pointer, so that one and everything after it are left null
+        to be written as silence.
+    */
+    const float* const* getChannelList (const int** data, int numChannels, Array<const float*>& list)
+    {
+        list.clearQuick();
+        bool isChannelMissing = false;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            isChannelMissing = isChannelMissing || data[i] == nullptr;
+            list.add (isChannelMissing ? nullptr : reinterpret_cast<const float*> (data[i]));
+        }
+
+        return list.getRawDataPointer();
     }
-    
-    void printChars (char* charPointer, int numChars)
+
+    /** Returns the SampleConversion format of a PCM file with this bit depth. Integer files are signed. */
+    SampleConversion::SampleFormat getFileSampleFormat (int bitsPerSample, bool isFloatingPoint) noexcept
     {
-#ifdef JUCE_DEBUG
-        while (--numChars >= 0)
+        if (isFloatingPoint)
+            return bitsPerSample == 64 ? SampleConversion::float64Format
+                                       : SampleConversion::float32Format;
+
+        switch (bitsPerSample)
         {
-            printf ("%c", *charPointer++);
+            case 8:     return SampleConversion::int8Format;
+            case 16:    return SampleConversion::int16Format;
+            case 24:    return SampleConversion::int24Format;
+            default:    jassert (bitsPerSample == 32); break;
         }
-        printf ("\n");
-#endif
+
+        return SampleConversion::int32Format;
+    }
+
+    /** True if samples of this size are unsigned in a WAV file, which 8-bit integers are. */
+    bool isUnsignedInWaveFile (unsigned int bitsPerSample, bool isFloatingPoint) noexcept
+    {
+        return bitsPerSample == 8 && ! isFloatingPoint;
+    }
+
+    //==============================================================================
+    /** Where the samples are in a file of packed, interleaved linear PCM. */
+    struct PcmLayout
+    {
+        int64 dataStart, dataLength;
+        int bytesPerFrame;
+        SampleConversion::SampleFormat sampleFormat;
+        bool isBigEndian;
+    };
+
+    /** True for linear PCM data that's made of integers which fit in 32 bits. */
+    bool isIntegerPcm (const AudioStreamBasicDescription& format) noexcept
+    {
+        return format.mFormatID == kAudioFormatLinearPCM
+                && (format.mFormatFlags & kAudioFormatFlagIsFloat) == 0
+                && format.mBitsPerChannel > 0
+                && format.mBitsPerChannel <= 32;
+    }
+
+    /** Fills in a PcmLayout for an open file, returning false if its samples can't be
+        read straight out of it, e.g. because it's compressed.
+    */
+    bool findPcmLayout (AudioFileID audioFile, PcmLayout& layout)
+    {
+        AudioStreamBasicDescription format;
+        UInt32 size = sizeof (format);
+
+        if (AudioFileGetProperty (audioFile, kAudioFilePropertyDataFormat, &size, &format) != noErr)
+            return false;
+
+        const int bits = (int) format.mBitsPerChannel;
+        const bool isFloatingPoint = (format.mFormatFlags & kAudioFormatFlagIsFloat) != 0;
+
+        if (format.mFormatID != kAudioFormatLinearPCM
+             || (format.mFormatFlags & kAudioFormatFlagIsNonInterleaved) != 0
+             || format.mChannelsPerFrame == 0
+             || format.mBytesPerFrame != format.mChannelsPerFrame * (UInt32) bits / 8
+             || (isFloatingPoint ? (bits != 32 && bits != 64)
+                                 : (bits != 8 && bits != 16 && bits != 24 && bits != 32)))
+            return false;
+
+        layout.sampleFormat = getFileSampleFormat (bits, isFloatingPoint);
+
+        // 8-bit WAV data is unsigned
+        if (bits == 8 && (format.mFormatFlags & kAudioFormatFlagIsSignedInteger) == 0)
+            layout.sampleFormat = SampleConversion::uint8Format;
+
+        layout.isBigEndian = (format.mFormatFlags & kAudioFormatFlagIsBigEndian) != 0;
+        layout.bytesPerFrame = (int) format.mBytesPerFrame;
+
+        SInt64 dataStart = 0;
+        UInt64 dataLength = 0;
+
+        size = sizeof (dataStart);
+        if (AudioFileGetProperty (audioFile, kAudioFilePropertyDataOffset, &size, &dataStart) != noErr)
+            return false;
+
+        size = sizeof (dataLength);
+        if (AudioFileGetProperty (audioFile, kAudioFilePropertyAudioDataByteCount, &size, &dataLength) != noErr)
+            return false;
+
+        layout.dataStart = (int64) dataStart;
+        layout.dataLength = (int64) dataLength;
+        return true;
+    }
+
+    //==============================================================================
+    /** A sidecar record of a file's length, sample rate and channel count.
+
+        Finding the length of a VBR file without a packet table means parsing every packet
+        in it, so the result is kept in a small file in the reader options' length cache
+        folder. Entries are keyed on the file's path, size and modification time, so a file
+        that's been changed never picks up a stale one.
+    */
+    class LengthCacheEntry
+    {
+    public:
+        LengthCacheEntry (const File& directory, const File& audioFile_)
+            : lengthInFrames (0), sampleRate (0), numChannels (0),
+              audioFile (audioFile_),
+              fileSize (audioFile_.getSize()),
+              modificationTime (audioFile_.getLastModificationTime().toMilliseconds())
+        {
+            const String identity (audioFile.getFullPathName() + "|" + String (fileSize) + "|" + String (modificationTime));
+            entryFile = directory.getChildFile (String::toHexString (identity.hashCode64()) + ".length");
+        }
+
+        /** Loads the entry for this file, if there's an up-to-date one. */
+        bool load()
+        {
+            MemoryBlock data;
+
+            if (! entryFile.loadFileAsData (data))
+                return false;
+
+            MemoryInputStream in (data, false);
+
+            if (in.readInt() != magicNumber
+                 || in.readString() != audioFile.getFullPathName()
+                 || in.readInt64() != fileSize
+                 || in.readInt64() != modificationTime)
+                return false;
+
+            lengthInFrames = in.readInt64();
+            sampleRate = in.readDouble();
+            numChannels = in.readInt();
+
+            return lengthInFrames >= 0 && ! in.isExhausted();
+        }
+
+        bool save() const
+        {
+            MemoryOutputStream out;
+            out.writeInt (magicNumber);
+            out.writeString (audioFile.getFullPathName());
+            out.writeInt64 (fileSize);
+            out.writeInt64 (modificationTime);
+            out.writeInt64 (lengthInFrames);
+            out.writeDouble (sampleRate);
+            out.writeInt (numChannels);
+            out.writeByte (0);      // so that a truncated entry can be spotted
+
+            return entryFile.getParentDirectory().createDirectory().wasOk()
+                    && entryFile.replaceWithData (out.getData(), out.getDataSize());
+        }
+
+        int64 lengthInFrames;
+        double sampleRate;
+        int numChannels;
+
+    private:
+        enum { magicNumber = 0x6c656e31 };   // 'len1'
+
+        File audioFile, entryFile;
+        int64 fileSize, modificationTime;
+
+        JUCE_DECLARE_NON_COPYABLE (LengthCacheEntry);
+    };
+
+    //==============================================================================
+    bool chunkIdIs (const void* data, const char* chunkId) noexcept
+    {
+        return memcmp (data, chunkId, strlen (chunkId)) == 0;
+    }
+
+    /** Checks whether the first bytes of a stream look like the start of a file that the
+        decoder might understand. This only reads a dozen bytes, so it's a lot cheaper
+        than setting up a decoder to find out, and rejects most files that aren't audio.
+    */
+    bool looksLikeAudioFile (InputStream& stream)
+    {
+        uint8 header[12] = { 0 };
+        const int64 originalPosition = stream.getPosition();
+        const int numRead = stream.setPosition (0) ? stream.read (header, sizeof (header)) : 0;
+        stream.setPosition (originalPosition);
+
+        if (numRead < (int) sizeof (header))
+            return false;
+
+        if (chunkIdIs (header, "caff")
+             || (chunkIdIs (header, "RIFF") && chunkIdIs (header + 8, "WAVE")))
+            return true;
+
+       #if JUCE_MAC || JUCE_IOS
+        if ((chunkIdIs (header, "RF64") && chunkIdIs (header + 8, "WAVE"))
+             || (chunkIdIs (header, "FORM") && (chunkIdIs (header + 8, "AIFF") || chunkIdIs (header + 8, "AIFC")))
+             || chunkIdIs (header + 4, "ftyp")      // MPEG-4 and 3GPP
+             || chunkIdIs (header, "ID3")
+             || chunkIdIs (header, ".snd")
+             || chunkIdIs (header, "fLaC")
+             || chunkIdIs (header, "OggS")
+             || chunkIdIs (header, "#!AMR"))
+            return true;
+
+        // MPEG audio and ADTS frames, and AC-3
+        if ((header[0] == 0xff && (header[1] & 0xe0) == 0xe0)
+             || (header[0] == 0x0b && header[1] == 0x77))
+            return true;
+       #endif
+
+        return false;
+    }
+
+    /** Fills in a FileInfo from the chunks of a linear PCM WAV file. */
+    bool probeWaveFile (InputStream& stream, int64 fileSize, CoreAudioFormat::FileInfo& info)
+    {
+        int64 position = 12;
+        int blockAlign = 0;
+
+        while (position + 8 <= fileSize && stream.setPosition (position))
+        {
+            char chunkHeader[4];
+
+            if (stream.read (chunkHeader, sizeof (chunkHeader)) != (int) sizeof (chunkHeader))
+                break;
+
+            const int64 chunkSize = (int64) (uint32) stream.readInt();
+            const int64 chunkStart = position + 8;
+
+            if (chunkIdIs (chunkHeader, "fmt "))
+            {
+                int formatTag = (uint16) stream.readShort();
+                info.numChannels = (unsigned int) (uint16) stream.readShort();
+                info.sampleRate = (double) (uint32) stream.readInt();
+                stream.skipNextBytes (4);   // bytes per second
+                blockAlign = (uint16) stream.readShort();
+                info.bitsPerSample = (unsigned int) (uint16) stream.readShort();
+
+                if (formatTag == 0xfffe && chunkSize >= 26)
+                {
+                    stream.skipNextBytes (8);   // extension size, valid bits and channel mask
+                    formatTag = (uint16) stream.readShort();
+                }
+
+                if (formatTag != 1 && formatTag != 3)
+                    return false;
+
+                info.usesFloatingPointData = (formatTag == 3);
+            }
+            else if (chunkIdIs (chunkHeader, "data"))
+            {
+                if (blockAlign <= 0 || info.numChannels == 0)
+                    return false;
+
+                // recorders that never finished writing leave the size empty or wrong
+                const int64 dataSize = (chunkSize == 0 || chunkStart + chunkSize > fileSize) ? fileSize - chunkStart
+                                                                                             : chunkSize;
+                info.formatName = "WAV";
+                info.lengthInSamples = dataSize / blockAlign;
+                return true;
+            }
+
+            position = chunkStart + chunkSize + (chunkSize & 1);
+        }
+
+        return false;
+    }
+
+    /** Fills in a FileInfo from the chunks of a CAF file. Compressed files need a packet
+        table, as there's no other way to find their length without reading them.
+    */
+    bool probeCafFile (InputStream& stream, int64 fileSize, CoreAudioFormat::FileInfo& info)
+    {
+        int64 position = 8;
+        int64 dataSize = -1, numValidFrames = -1;
+        int bytesPerPacket = 0, framesPerPacket = 0;
+        bool foundFormat = false;
+
+        while (position + 12 <= fileSize && stream.setPosition (position))
+        {
+            char chunkHeader[4];
+
+            if (stream.read (chunkHeader, sizeof (chunkHeader)) != (int) sizeof (chunkHeader))
+                break;
+
+            const int64 chunkSize = stream.readInt64BigEndian();
+            const int64 chunkStart = position + 12;
+
+            if (chunkIdIs (chunkHeader, "desc"))
+            {
+                info.sampleRate = stream.readDoubleBigEndian();
+                const int formatID = stream.readIntBigEndian();
+                const int formatFlags = stream.readIntBigEndian();
+                bytesPerPacket = stream.readIntBigEndian();
+                framesPerPacket = stream.readIntBigEndian();
+                info.numChannels = (unsigned int) stream.readIntBigEndian();
+                info.bitsPerSample = (unsigned int) stream.readIntBigEndian();
+
+                info.usesFloatingPointData = (formatID != (int) kAudioFormatLinearPCM) || (formatFlags & 1) != 0;
+                foundFormat = true;
+            }
+            else if (chunkIdIs (chunkHeader, "pakt"))
+            {
+                stream.skipNextBytes (8);   // number of packets
+                numValidFrames = stream.readInt64BigEndian();
+            }
+            else if (chunkIdIs (chunkHeader, "data"))
+            {
+                // the data chunk's size is -1 while it's still being written, and it then runs to the end
+                const bool isSizeKnown = chunkSize >= 0 && chunkSize <= fileSize - chunkStart;
+                dataSize = (isSizeKnown ? chunkSize : fileSize - chunkStart) - 4;   // minus the edit count
+
+                if (! isSizeKnown)
+                    break;
+            }
+
+            // a corrupt size could send us back round the same chunks forever, or overflow the
+            // position, and either way there's nothing more to be found after it
+            if (chunkSize < 0 || chunkSize > fileSize - chunkStart)
+                break;
+
+            jassert (chunkStart + chunkSize > position);
+
+            position = chunkStart + chunkSize;
+        }
+
+        if (! foundFormat || dataSize < 0 || info.numChannels == 0)
+            return false;
+
+        if (numValidFrames >= 0)
+            info.lengthInSamples = numValidFrames;
+        else if (bytesPerPacket > 0 && framesPerPacket > 0)
+            info.lengthInSamples = dataSize / bytesPerPacket * framesPerPacket;
+        else
+            return false;
+
+        info.formatName = "CAF";
+        return true;
     }
 }
 
@@ -82,13 +625,25 @@ namespace
 class CoreAudioReader : public AudioFormatReader
 {
 public:
-    CoreAudioReader (InputStream* const inp)
+    CoreAudioReader (InputStream* const inp, const CoreAudioFormat::ReaderOptions& options)
         : AudioFormatReader (inp, TRANS (coreAudioFormatName)),
-          ok (false), lastReadPosition (0)
+          ok (false), audioFileID (nullptr), audioFileRef (nullptr), lastReadPosition (0),
+          minimumChunkSize (jmax (1, options.minimumChunkFrames)),
+          maximumChunkSize (minimumChunkSize),
+          chunkSize (minimumChunkSize),
+          memoryBudget (options.memoryBudgetBytes)
     {
         usesFloatingPointData = true;
         bitsPerSample = 32;
 
+        if (dynamic_cast<MemoryInputStream*> (input) == nullptr)
+            readAhead = new ReadAheadInput (*input, readAheadBlockSize, numReadAheadCachedBlocks,
+                                            jmax (0, options.readAheadBytes));
+
+        if (options.useSharedBlockCache)
+            if (FileInputStream* const fileStream = dynamic_cast<FileInputStream*> (input))
+                blockCacheIdentity = DecodedBlockCache::getFileIdentity (fileStream->getFile());
+
         OSStatus status = AudioFileOpenWithCallbacks (this,
                                                       &readCallback,
                                                       0,        // write needs to be null to avoid permisisions errors
@@ -112,18 +667,24 @@ public:
                 numChannels = sourceAudioFormat.mChannelsPerFrame;
                 sampleRate  = sourceAudioFormat.mSampleRate;
 
-                UInt32 sizeOfLengthProperty = sizeof (int64);
-                ExtAudioFileGetProperty (audioFileRef,
-                                         kExtAudioFileProperty_FileLengthFrames,
-                                         &sizeOfLengthProperty,
-                                         &lengthInSamples);
+                findLength (options);
+
+                // integer PCM comes out as left-justified ints, so that callers who want
+                // integers don't get them converted to floats and back again
+                if (isIntegerPcm (sourceAudioFormat))
+                {
+                    usesFloatingPointData = false;
+                    bitsPerSample = sourceAudioFormat.mBitsPerChannel;
+                }
 
                 destinationAudioFormat.mSampleRate       = sampleRate;
                 destinationAudioFormat.mFormatID         = kAudioFormatLinearPCM;
-                destinationAudioFormat.mFormatFlags      = kLinearPCMFormatFlagIsFloat | kLinearPCMFormatFlagIsNonInterleaved | kAudioFormatFlagsNativeEndian;
-                destinationAudioFormat.mBitsPerChannel   = sizeof (float) * 8;
+                destinationAudioFormat.mFormatFlags      = (usesFloatingPointData ? kLinearPCMFormatFlagIsFloat
+                                                                                  : (kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked))
+                                                             | kLinearPCMFormatFlagIsNonInterleaved | kAudioFormatFlagsNativeEndian;
+                destinationAudioFormat.mBitsPerChannel   = 32;
                 destinationAudioFormat.mChannelsPerFrame = numChannels;
-                destinationAudioFormat.mBytesPerFrame    = sizeof (float);
+                destinationAudioFormat.mBytesPerFrame    = 4;
                 destinationAudioFormat.mFramesPerPacket  = 1;
                 destinationAudioFormat.mBytesPerPacket   = destinationAudioFormat.mFramesPerPacket * destinationAudioFormat.mBytesPerFrame;
 
@@ -135,6 +696,10 @@ public:
                 {
                     bufferList.malloc (1, sizeof (AudioBufferList) + numChannels * sizeof (AudioBuffer));
                     bufferList->mNumberBuffers = numChannels;
+                    blockChannels.malloc (numChannels);
+
+                    const int64 bytesPerFrame = (int64) sizeof (int) * jmax (1, (int) numChannels);
+                    maximumChunkSize = jmax (minimumChunkSize, (int) jmin ((int64) 0x7fffffff, memoryBudget / bytesPerFrame));
                     ok = true;
                 }
             }
@@ -143,8 +708,13 @@ public:
 
     ~CoreAudioReader()
     {
-        ExtAudioFileDispose (audioFileRef);
-        AudioFileClose (audioFileID);
+        if (audioFileRef != nullptr)
+            ExtAudioFileDispose (audioFileRef);
+
+        if (audioFileID != nullptr)
+            AudioFileClose (audioFileID);
+
+        readAhead = nullptr;
     }
 
     //==============================================================================
@@ -166,6 +736,41 @@ public:
         if (numSamples <= 0)
             return true;
 
+        for (int i = numDestChannels; --i >= (int) numChannels;)
+            if (destSamples[i] != nullptr)
+                zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+        if (blockCacheIdentity.isNotEmpty())
+            return readThroughBlockCache (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+
+        return decode (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    const CoreAudioFormat::ReaderStatistics& getStatistics() const noexcept     { return statistics; }
+
+    bool getPcmLayout (PcmLayout& layout) const     { return findPcmLayout (audioFileID, layout); }
+
+    bool ok;
+
+private:
+    AudioFileID audioFileID;
+    ExtAudioFileRef audioFileRef;
+    AudioStreamBasicDescription destinationAudioFormat;
+    MemoryBlock audioDataBlock;     // where channels that the caller doesn't want are decoded to
+    HeapBlock<AudioBufferList> bufferList;
+    ScopedPointer<ReadAheadInput> readAhead;
+    String blockCacheIdentity;
+    HeapBlock<int*> blockChannels;
+    int64 lastReadPosition;
+    const int minimumChunkSize;
+    int maximumChunkSize, chunkSize;
+    const int64 memoryBudget;
+    CoreAudioFormat::ReaderStatistics statistics;
+
+    /** Decodes samples from the file into the caller's buffers. */
+    bool decode (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                 int64 startSampleInFile, int numSamples)
+    {
         if (lastReadPosition != startSampleInFile)
         {
             OSStatus status = ExtAudioFileSeek (audioFileRef, startSampleInFile);
@@ -173,22 +778,36 @@ public:
                 return false;
 
             lastReadPosition = startSampleInFile;
+
+            // a jump probably means scrubbing, so go back to small chunks until the reads settle down
+            chunkSize = minimumChunkSize;
+            ++statistics.numSeeks;
         }
 
+        // the file's channels are decoded straight into the caller's buffers, and any that
+        // the caller doesn't want all go into the same scratch block
         while (numSamples > 0)
         {
-            const int numThisTime = jmin (8192, numSamples);
-            const size_t numBytes = sizeof (float) * (size_t) numThisTime;
-
-            audioDataBlock.ensureSize (numBytes * numChannels, false);
-            float* data = static_cast<float*> (audioDataBlock.getData());
+            const int numThisTime = jmin (chunkSize, numSamples);
+            const size_t numBytes = sizeof (int) * (size_t) numThisTime;
 
             for (int j = (int) numChannels; --j >= 0;)
             {
+                void* dest = j < numDestChannels ? destSamples[j] : nullptr;
+
+                if (dest != nullptr)
+                {
+                    dest = static_cast<int*> (dest) + startOffsetInDestBuffer;
+                }
+                else
+                {
+                    audioDataBlock.ensureSize (numBytes, false);
+                    dest = audioDataBlock.getData();
+                }
+
                 bufferList->mBuffers[j].mNumberChannels = 1;
                 bufferList->mBuffers[j].mDataByteSize = (UInt32) numBytes;
-                bufferList->mBuffers[j].mData = data;
-                data += numThisTime;
+                bufferList->mBuffers[j].mData = dest;
             }
 
             UInt32 numFramesToRead = (UInt32) numThisTime;
@@ -196,38 +815,124 @@ public:
             if (status != noErr)
                 return false;
 
-            for (int i = numDestChannels; --i >= 0;)
+            // if the file came up short, the rest of the block is silent
+            if ((int) numFramesToRead < numThisTime)
+                for (int i = jmin (numDestChannels, (int) numChannels); --i >= 0;)
+                    if (destSamples[i] != nullptr)
+                        zeromem (destSamples[i] + startOffsetInDestBuffer + numFramesToRead,
+                                 sizeof (int) * (size_t) (numThisTime - (int) numFramesToRead));
+
+            startOffsetInDestBuffer += numThisTime;
+            numSamples -= numThisTime;
+            lastReadPosition += numThisTime;
+
+            noteChunkDecoded (numThisTime);
+        }
+
+        return true;
+    }
+
+    /** Copies samples out of the blocks in the shared cache, decoding and adding any
+        that other readers of the file haven't already.
+
+        The blocks hold whatever this reader gives out, which for integer files is ints
+        rather than floats. That's the same for every reader of a file, so they can
+        still share them, but a block of the wrong kind is decoded again anyway.
+    */
+    bool readThroughBlockCache (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                int64 startSampleInFile, int numSamples)
+    {
+        DecodedBlockCache& cache = DecodedBlockCache::getSharedInstance();
+        const int numChannelsToCopy = jmin (numDestChannels, (int) numChannels);
+
+        while (numSamples > 0)
+        {
+            const int64 blockIndex = startSampleInFile / framesPerCachedBlock;
+            const int64 blockStart = blockIndex * framesPerCachedBlock;
+            DecodedBlockCache::Block::Ptr block (cache.find (blockCacheIdentity, blockIndex));
+
+            if (block == nullptr || block->isFloatingPoint() != usesFloatingPointData)
             {
-                if (destSamples[i] != nullptr)
-                {
-                    if (i < (int) numChannels)
-                        memcpy (destSamples[i] + startOffsetInDestBuffer, bufferList->mBuffers[i].mData, numBytes);
-                    else
-                        zeromem (destSamples[i] + startOffsetInDestBuffer, numBytes);
-                }
+                block = new DecodedBlockCache::Block ((int) numChannels,
+                                                      (int) jmin ((int64) framesPerCachedBlock, lengthInSamples - blockStart),
+                                                      usesFloatingPointData);
+
+                for (int i = (int) numChannels; --i >= 0;)
+                    blockChannels[i] = block->getChannel (i);
+
+                if (! decode (blockChannels, (int) numChannels, 0, blockStart, block->getNumFrames()))
+                    return false;
+
+                cache.add (blockCacheIdentity, blockIndex, block);
             }
 
+            const int offsetInBlock = (int) (startSampleInFile - blockStart);
+            const int numThisTime = jmin (numSamples, block->getNumFrames() - offsetInBlock);
+            jassert (numThisTime > 0);
+
+            for (int i = numChannelsToCopy; --i >= 0;)
+                if (destSamples[i] != nullptr)
+                    memcpy (destSamples[i] + startOffsetInDestBuffer, block->getChannel (i) + offsetInBlock,
+                            sizeof (int) * (size_t) numThisTime);
+
             startOffsetInDestBuffer += numThisTime;
+            startSampleInFile += numThisTime;
             numSamples -= numThisTime;
-            lastReadPosition += numThisTime;
         }
 
         return true;
     }
 
-    bool ok;
+    /** Finds the length of the file, from its length cache entry if it has an up-to-date one. */
+    void findLength (const CoreAudioFormat::ReaderOptions& options)
+    {
+        ScopedPointer<LengthCacheEntry> cacheEntry;
 
-private:
-    AudioFileID audioFileID;
-    ExtAudioFileRef audioFileRef;
-    AudioStreamBasicDescription destinationAudioFormat;
-    MemoryBlock audioDataBlock;
-    HeapBlock<AudioBufferList> bufferList;
-    int64 lastReadPosition;
+        if (options.lengthCacheDirectory != File::nonexistent)
+            if (FileInputStream* const fileStream = dynamic_cast<FileInputStream*> (input))
+                cacheEntry = new LengthCacheEntry (options.lengthCacheDirectory, fileStream->getFile());
+
+        if (cacheEntry != nullptr && cacheEntry->load()
+             && cacheEntry->sampleRate == sampleRate && cacheEntry->numChannels == (int) numChannels)
+        {
+            lengthInSamples = cacheEntry->lengthInFrames;
+            return;
+        }
+
+        UInt32 sizeOfLengthProperty = sizeof (int64);
+        ExtAudioFileGetProperty (audioFileRef,
+                                 kExtAudioFileProperty_FileLengthFrames,
+                                 &sizeOfLengthProperty,
+                                 &lengthInSamples);
+
+        if (cacheEntry != nullptr)
+        {
+            cacheEntry->lengthInFrames = lengthInSamples;
+            cacheEntry->sampleRate = sampleRate;
+            cacheEntry->numChannels = (int) numChannels;
+            cacheEntry->save();
+        }
+    }
+
+    void noteChunkDecoded (int numFrames) noexcept
+    {
+        statistics.smallestChunk = statistics.numChunks == 0 ? numFrames : jmin (statistics.smallestChunk, numFrames);
+        statistics.largestChunk = jmax (statistics.largestChunk, numFrames);
+        statistics.numFramesDecoded += numFrames;
+        ++statistics.numChunks;
+
+        // the longer a run of sequential reads goes on, the bigger the chunks get
+        chunkSize = jmin (maximumChunkSize, chunkSize * 2);
+    }
 
     static SInt64 getSizeCallback (void* inClientData)
     {
-        return static_cast<CoreAudioReader*> (inClientData)->input->getTotalLength();
+        CoreAudioReader* const reader = static_cast<CoreAudioReader*> (inClientData);
+
+        if (reader->readAhead != nullptr)
+            return reader->readAhead->getTotalLength();
+
+        return reader->input->getTotalLength();
     }
 
     static OSStatus readCallback (void* inClientData,
@@ -238,58 +943,156 @@ private:
     {
         CoreAudioReader* const reader = static_cast<CoreAudioReader*> (inClientData);
 
-        reader->input->setPosition (inPosition);
-        *actualCount = (UInt32) reader->input->read (buffer, (int) requestCount);
+        if (reader->readAhead != nullptr)
+        {
+            *actualCount = (UInt32) reader->readAhead->readAt (inPosition, buffer, (int) requestCount);
+        }
+        else
+        {
+            reader->input->setPosition (inPosition);
+            *actualCount = (UInt32) reader->input->read (buffer, (int) requestCount);
+        }
+
+        return noErr;
+    }
+
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreAudioReader);
+};
+
+//==============================================================================
+/** Reads a PCM file's samples straight out of a memory-mapped view of it.
+
+    Like CoreAudioReader, this gives out left-justified ints for integer files and
+    floats for anything else.
+*/
+class MemoryMappedCoreAudioReader  : public MemoryMappedAudioFormatReader
+{
+public:
+    MemoryMappedCoreAudioReader (const File& file, const AudioFormatReader& details, const PcmLayout& layout_)
+        : MemoryMappedAudioFormatReader (file, details, layout_.dataStart, layout_.dataLength, layout_.bytesPerFrame),
+          layout (layout_),
+          bytesPerSample (SampleConversion::getBytesPerSample (layout_.sampleFormat)),
+          destChannels ((size_t) details.numChannels)
+    {
+        lengthInSamples = jmin (lengthInSamples, layout.dataLength / layout.bytesPerFrame);
+    }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples)
+    {
+        jassert (destSamples != nullptr);
+        const int64 samplesAvailable = lengthInSamples - startSampleInFile;
+
+        if (samplesAvailable < numSamples)
+        {
+            for (int i = numDestChannels; --i >= 0;)
+                if (destSamples[i] != nullptr)
+                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+            numSamples = (int) samplesAvailable;
+        }
+
+        if (numSamples <= 0)
+            return true;
+
+        if (map == nullptr || ! mappedSection.contains (Range<int64> (startSampleInFile, startSampleInFile + numSamples)))
+        {
+            jassertfalse;   // the mapped section has to cover all the samples that are read
+            return false;
+        }
+
+        for (int i = numDestChannels; --i >= (int) numChannels;)
+            if (destSamples[i] != nullptr)
+                zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+
+        const int numToConvert = jmin (numDestChannels, (int) numChannels);
+
+        for (int i = 0; i < numToConvert; ++i)
+            destChannels[i] = destSamples[i] != nullptr ? destSamples[i] + startOffsetInDestBuffer : nullptr;
+
+        if (usesFloatingPointData)
+            SampleConversion::convertFromInterleaved (sampleToPointer (startSampleInFile), (int) numChannels,
+                                                      layout.sampleFormat, layout.isBigEndian,
+                                                      reinterpret_cast<float* const*> (destChannels.getData()), numToConvert, numSamples);
+        else
+            SampleConversion::convertFromInterleaved (sampleToPointer (startSampleInFile), (int) numChannels,
+                                                      layout.sampleFormat, layout.isBigEndian,
+                                                      destChannels, numToConvert, numSamples);
+        return true;
+    }
+
+    void getSample (int64 sample, float* result) const noexcept
+    {
+        if (map == nullptr || ! mappedSection.contains (sample))
+        {
+            jassertfalse;   // the sample has to be inside the mapped section
+            zeromem (result, sizeof (float) * numChannels);
+            return;
+        }
+
+        const void* const frame = sampleToPointer (sample);
 
-        return noErr;
+        for (int i = 0; i < (int) numChannels; ++i)
+        {
+            float* const dest = result + i;
+            SampleConversion::convertFromInterleaved (addBytesToPointer (frame, i * bytesPerSample), (int) numChannels,
+                                                      layout.sampleFormat, layout.isBigEndian, &dest, 1, 1);
+        }
     }
 
-    
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreAudioReader);
+private:
+    const PcmLayout layout;
+    const int bytesPerSample;
+    HeapBlock<int*> destChannels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedCoreAudioReader);
 };
 
 //==============================================================================
-class CoreAudioWriter  : public AudioFormatWriter
+class CoreAudioWriter  : public AudioFormatWriter,
+                         private StagingBuffer::Target
 {
 public:
     CoreAudioWriter (OutputStream* const out, const double sampleRate_,
                      const unsigned int numChannels_, const unsigned int bits,
-                     const StringPairArray& metadataValues)
+                     const bool isFloatingPoint, const StringPairArray& metadataValues,
+                     const CoreAudioFormat::WriterOptions& options_)
         : AudioFormatWriter (out, TRANS (coreAudioFormatName), sampleRate_, numChannels_, bits),
           writeFailed (true),
-          bytesWritten (0)
+          audioFileID (nullptr),
+          audioFileRef (nullptr),
+          staging (*this, (int) numChannels_, options_.stagingSize),
+          fileSampleFormat (isUnsignedInWaveFile (bits, isFloatingPoint) ? SampleConversion::uint8Format
+                                                                        : getFileSampleFormat ((int) bits, isFloatingPoint)),
+          fileBytesPerFrame ((int) (numChannels_ * bits / 8)),
+          options (options_),
+          dither (options_.dither ? new SampleConversion::DitherState() : nullptr),
+          fileSize (0),
+          durability (options_),
+          shadow ((size_t) jmax (0, options_.shadowSize), true)
     {
         usesFloatingPointData = true;
         bitsPerSample = 32;
-        
-        // this appears to return all the types, even those specified by the docs as non-writable
-        StringArray types (findWritableTypes());
-        for (int i = 0; i < types.size(); ++i)
-        {
-            DBG (types[i]);
-        }
-        
-        // set the input stream to the output stream's start
-        updateInputStream();
-//        FileOutputStream* fileCheck = dynamic_cast<FileOutputStream*> (out);
-//        if (fileCheck != nullptr)
-//            input = new FileInputStream (fileCheck->getFile());
-//
-//        MemoryOutputStream* memoryCheck = dynamic_cast<MemoryOutputStream*> (out);
-//        if (memoryCheck != nullptr)
-//            input = new MemoryInputStream (memoryCheck->getData(), memoryCheck->getDataSize(), false);
-        
+
         // destination format
         AudioStreamBasicDescription destinationAudioFormat;
         destinationAudioFormat.mSampleRate       = sampleRate;
         destinationAudioFormat.mFormatID         = kAudioFormatLinearPCM;
-        destinationAudioFormat.mFormatFlags      = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
-        destinationAudioFormat.mBitsPerChannel   = bits; //sizeof (int16) * 8;
-        destinationAudioFormat.mChannelsPerFrame = 1;//numChannels;
-        destinationAudioFormat.mBytesPerFrame    = bits / 8; //sizeof (int16);
+        destinationAudioFormat.mFormatFlags      = (isFloatingPoint ? kLinearPCMFormatFlagIsFloat
+                                                                    : (isUnsignedInWaveFile (bits, isFloatingPoint) ? 0 : kLinearPCMFormatFlagIsSignedInteger))
+                                                     | kLinearPCMFormatFlagIsPacked;
+        destinationAudioFormat.mBitsPerChannel   = bits;
+        destinationAudioFormat.mChannelsPerFrame = numChannels;
+        destinationAudioFormat.mBytesPerFrame    = numChannels * bits / 8;
         destinationAudioFormat.mFramesPerPacket  = 1;
         destinationAudioFormat.mBytesPerPacket   = destinationAudioFormat.mFramesPerPacket * destinationAudioFormat.mBytesPerFrame;
-        
+
+        destination = createDestinationFor (*out, options, sampleRate, (int) destinationAudioFormat.mBytesPerFrame);
+
+        // the system's list appears to have all the types in it, even those the docs say aren't writable
+        jassert (CodecRegistry::getInstance().canWrite (kAudioFileWAVEType));
+
         audioFileID = NULL;
         OSStatus status = AudioFileInitializeWithCallbacks (this, 
                                                             &readCallback,
@@ -320,17 +1123,10 @@ public:
             
             if (status == noErr)
             {
-                // the format that we will supply to the writer
-                AudioStreamBasicDescription sourceAudioFormat;
-                sourceAudioFormat.mSampleRate       = sampleRate;
-                sourceAudioFormat.mFormatID         = kAudioFormatLinearPCM;
-                sourceAudioFormat.mFormatFlags      = kLinearPCMFormatFlagIsFloat | kLinearPCMFormatFlagIsNonInterleaved | kAudioFormatFlagsNativeEndian;
-                sourceAudioFormat.mBitsPerChannel   = sizeof (float) * 8;
-                sourceAudioFormat.mChannelsPerFrame = numChannels;
-                sourceAudioFormat.mBytesPerFrame    = sizeof (float);
-                sourceAudioFormat.mFramesPerPacket  = 1;
-                sourceAudioFormat.mBytesPerPacket   = sourceAudioFormat.mFramesPerPacket * sourceAudioFormat.mBytesPerFrame;
-                
+                // the samples are converted to the file's own format before the encoder sees them,
+                // so that it only has to copy them into the file
+                const AudioStreamBasicDescription sourceAudioFormat (destinationAudioFormat);
+
                 status = ExtAudioFileSetProperty (audioFileRef,
                                                   kExtAudioFileProperty_ClientDataFormat,
                                                   sizeof (AudioStreamBasicDescription),
@@ -345,8 +1141,9 @@ public:
 
                 if (status == noErr)
                 {
-                    bufferList.malloc (1, sizeof (AudioBufferList) + numChannels * sizeof (AudioBuffer));
-                    bufferList->mNumberBuffers = numChannels;
+                    bufferList.malloc (1, sizeof (AudioBufferList));
+                    bufferList->mNumberBuffers = 1;
+                    bufferList->mBuffers[0].mNumberChannels = numChannels;
                     writeFailed = false;
                 }
             }
@@ -355,8 +1152,16 @@ public:
     
     ~CoreAudioWriter()
     {
-        ExtAudioFileDispose (audioFileRef);
-        AudioFileClose (audioFileID);
+        if (audioFileRef != nullptr)
+        {
+            writeStagedSamples();
+            ExtAudioFileDispose (audioFileRef);
+        }
+
+        if (audioFileID != nullptr)
+            AudioFileClose (audioFileID);
+
+        destination->flush();
     }
     
     //==============================================================================
@@ -366,19 +1171,60 @@ public:
 
         if (writeFailed)
             return false;
-        
-        const size_t numBytes = sizeof (float) * (size_t) numSamples;
-        
-        for (int j = (int) numChannels; --j >= 0;)
-        {
-            if (data[j] != nullptr)
-            {
-                bufferList->mBuffers[j].mNumberChannels = 1;
-                bufferList->mBuffers[j].mDataByteSize = (UInt32) numBytes;
-                bufferList->mBuffers[j].mData = (void*) data[j];
-            }
-        }
-        
+
+        return staging.write (reinterpret_cast<const float**> (data), numSamples);
+    }
+
+    /** Writes out any samples that are waiting in the staging buffer, and flushes the
+        destination, so that everything written so far is safely in the file.
+    */
+    bool flush()
+    {
+        return writeStagedSamples() && destination->flush();
+    }
+
+    bool isBypassingCache() const noexcept  { return destination->isBypassingCache(); }
+
+    /** Stops the base class deleting the stream, for when creating the writer fails. */
+    void releaseOutputStream() noexcept     { output = nullptr; }
+
+    bool writeFailed;
+
+private:
+    //==============================================================================
+    AudioFileID audioFileID;
+    ExtAudioFileRef audioFileRef;
+    HeapBlock<AudioBufferList> bufferList;
+    StagingBuffer staging;              // where small blocks are gathered, so the encoder sees fewer, bigger ones
+    MemoryBlock encodeBuffer;           // the samples, converted to the file's format
+    Array<const float*> channelList;
+    const SampleConversion::SampleFormat fileSampleFormat;
+    const int fileBytesPerFrame;
+    const CoreAudioFormat::WriterOptions options;
+    ScopedPointer<SampleConversion::DitherState> dither;
+    int64 fileSize;
+    DurabilityTracker durability;
+    MemoryBlock shadow;                         // a copy of the start of the file, for serving the encoder's header reads
+    ScopedPointer<PositionalOutput> destination;  // all the encoder's reads and writes go through this
+
+    //==============================================================================
+    bool writeStagedSamples()
+    {
+        return ! writeFailed && staging.flush();
+    }
+
+    bool writeBlock (const float** channels, int numSamples)
+    {
+        const size_t numBytes = (size_t) (numSamples * fileBytesPerFrame);
+        encodeBuffer.ensureSize (numBytes, false);
+
+        SampleConversion::convertToInterleaved (getChannelList (reinterpret_cast<const int**> (channels), (int) numChannels, channelList),
+                                                (int) numChannels, encodeBuffer.getData(), fileSampleFormat, false,
+                                                numSamples, dither);
+
+        bufferList->mBuffers[0].mDataByteSize = (UInt32) numBytes;
+        bufferList->mBuffers[0].mData = encodeBuffer.getData();
+
         UInt32 numFramesToWrite = (UInt32) numSamples;
 
         OSStatus status = ExtAudioFileWrite (audioFileRef, numFramesToWrite, bufferList);
@@ -395,142 +1241,431 @@ public:
 
         return false;
     }
-    
-    bool writeFailed;
 
-private:
-    //==============================================================================
-    AudioFileID audioFileID;
-    ExtAudioFileRef audioFileRef;
-    HeapBlock<AudioBufferList> bufferList;
-    uint64 bytesWritten;
-    ScopedPointer<InputStream> input;
-    //int64 expectedSize;
-    //MemoryBlock tempBlock;
-    
     //==============================================================================
     static SInt64 getSizeCallback (void* inClientData)
     {
-        CoreAudioWriter* const writer = static_cast<CoreAudioWriter*> (inClientData);
-        const SInt64 size = writer->bytesWritten;//writer->input->getTotalLength();
-        DBG ("getSizeCallback " << (int) size);
-        return size;
-
-//
-//        return writer->tempBlock.getSize();//expectedSize;//bytesWritten;
+        return static_cast<CoreAudioWriter*> (inClientData)->fileSize;
     }
-    
+
     static OSStatus readCallback (void* inClientData,
                                   SInt64 inPosition,
                                   UInt32 requestCount,
                                   void* buffer,
                                   UInt32* actualCount)
     {
-//        DBG ("readCallback - pos: " << (int) inPosition << " bytes: " << (int) requestCount);
-//        CoreAudioWriter* const writer = static_cast<CoreAudioWriter*> (inClientData);
-//        memcpy (addBytesToPointer (writer->tempBlock.getData(), inPosition), buffer, requestCount);
-//        *actualCount = requestCount;
         CoreAudioWriter* const writer = static_cast<CoreAudioWriter*> (inClientData);
-        
-        const bool seekSucceeded = writer->input->setPosition (inPosition);
-        *actualCount = (UInt32) writer->input->read (buffer, (int) requestCount);
-
-        DBG ("readCallback - pos: " << (int) inPosition << " bytes: " << (int) requestCount << " actual: " << (int) *actualCount << " seek: " << seekSucceeded);
-        DBG ("read length" << (int) writer->input->getTotalLength());
-        printChars ((char*) buffer, requestCount);
+        *actualCount = (UInt32) writer->readFromFile (inPosition, buffer, (int) requestCount);
 
         return noErr;
     }
 
     static OSStatus writeCallback (void* inClientData,
-                                   SInt64 inPosition, 
-                                   UInt32 requestCount, 
-                                   const void* buffer, 
+                                   SInt64 inPosition,
+                                   UInt32 requestCount,
+                                   const void* buffer,
                                    UInt32* actualCount)
     {
         CoreAudioWriter* const writer = static_cast<CoreAudioWriter*> (inClientData);
-        
-        //const bool success = writer->output->write (addBytesToPointer (buffer, inPosition), requestCount);
-        writer->output->setPosition (inPosition);
-        const bool success = writer->output->write (buffer, requestCount);
 
-        if (success)
+        if (writer->writeToFile (inPosition, buffer, (int) requestCount))
         {
-//            writer->tempBlock.ensureSize (writer->tempBlock.getSize() + requestCount + inPosition);
-//            memcpy (addBytesToPointer (writer->tempBlock.getData(), inPosition), buffer, requestCount);
-
-            writer->bytesWritten += requestCount;
-            DBG ("writeCallback - pos: " << (int) inPosition << " bytes: " << (int) requestCount << " total: " << (int) writer->bytesWritten);
             *actualCount = requestCount;
-            writer->updateInputStream();
-
-            printChars ((char*) buffer, requestCount);
-
             return noErr;
         }
-        else
-        {
-            DBG ("write error");
-            *actualCount = 0;
-            return success;
-        }
+
+        DBG ("write error");
+        *actualCount = 0;
+        return kAudioFileUnspecifiedError;
     }
-    
+
     static OSStatus setSizeCallback (void* inClientData,
                                      SInt64 inSize)
     {
-        DBG ("setSizeCallback: " << (int) inSize);
         CoreAudioWriter* const writer = static_cast<CoreAudioWriter*> (inClientData);
 
-        const int64 numBytesToPad = inSize - writer->bytesWritten;
-        writer->bytesWritten += numBytesToPad;
-        writer->output->writeRepeatedByte (0, numBytesToPad);
-        writer->updateInputStream();
+        // OutputStreams can't be truncated, so shrinking the file just moves the logical end
+        if (inSize > writer->fileSize)
+        {
+            const int64 numBytesToPad = inSize - writer->fileSize;
+            writer->updateShadowWithZeros (writer->fileSize, numBytesToPad);
+
+            // the space between the logical and physical ends may still hold old data
+            if (! (writer->destination->getSize() <= writer->fileSize
+                     || writer->clearFileRange (writer->fileSize, jmin (inSize, writer->destination->getSize()))))
+                return kAudioFileUnspecifiedError;
+
+            if (! writer->destination->growTo (inSize))
+                return kAudioFileUnspecifiedError;
+
+            writer->durability.noteBytesWritten (*writer->destination, numBytesToPad);
+        }
 
+        writer->fileSize = inSize;
         return noErr;
     }
-    
-    void updateInputStream()
+
+    //==============================================================================
+    bool writeToFile (int64 position, const void* data, int numBytes)
     {
-        output->flush();
-        
-        FileOutputStream* fileCheck = dynamic_cast<FileOutputStream*> (output);
-        if (fileCheck != nullptr)
+        updateShadow (position, data, numBytes);
+
+        if (! destination->writeAt (position, data, (size_t) numBytes))
+            return false;
+
+        fileSize = jmax (fileSize, position + numBytes);
+        durability.noteBytesWritten (*destination, numBytes);
+        return true;
+    }
+
+    int readFromFile (int64 position, void* dest, int numBytes)
+    {
+        numBytes = (int) jmin ((int64) numBytes, fileSize - position);
+
+        if (numBytes <= 0)
+            return 0;
+
+        // the encoder almost always re-reads its header, which we can serve straight from memory
+        const int numInShadow = (int) jmax ((int64) 0, jmin ((int64) numBytes, (int64) shadow.getSize() - position));
+
+        if (numInShadow > 0)
+            shadow.copyTo (dest, (int) position, (size_t) numInShadow);
+
+        if (numInShadow == numBytes)
+            return numBytes;
+
+        return numInShadow + destination->readAt (position + numInShadow,
+                                                  addBytesToPointer (dest, numInShadow),
+                                                  numBytes - numInShadow);
+    }
+
+    bool clearFileRange (int64 start, int64 end)
+    {
+        HeapBlock<char> zeros (4096, true);
+
+        for (; start < end; start += 4096)
+            if (! destination->writeAt (start, zeros, (size_t) jmin ((int64) 4096, end - start)))
+                return false;
+
+        return true;
+    }
+
+    void updateShadow (int64 position, const void* data, int numBytes)
+    {
+        const int numToCopy = (int) jmin ((int64) numBytes, (int64) shadow.getSize() - position);
+
+        if (numToCopy > 0)
+            shadow.copyFrom (data, (int) position, (size_t) numToCopy);
+    }
+
+    void updateShadowWithZeros (int64 position, int64 numBytes)
+    {
+        const int64 numToClear = jmin (numBytes, (int64) shadow.getSize() - position);
+
+        if (numToClear > 0)
+            zeromem (addBytesToPointer (shadow.getData(), position), (size_t) numToClear);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreAudioWriter);
+};
+
+//==============================================================================
+/** Writes linear PCM CAF files directly, without going through the AudioFile API.
+
+    The header is written up-front with a data chunk size of -1, which CAF defines
+    as "runs to the end of the file", so everything after that is a plain sequential
+    append. If the stream can seek, the real size is patched in when the writer is
+    deleted; if it can't, or the recording is cut short, the file is still readable.
+*/
+class CafStreamingWriter  : public AudioFormatWriter,
+                            private StagingBuffer::Target
+{
+public:
+    CafStreamingWriter (OutputStream* const out, const double sampleRate_,
+                        const unsigned int numChannels_, const unsigned int bits,
+                        const bool isFloatingPoint, const CoreAudioFormat::WriterOptions& options)
+        : AudioFormatWriter (out, TRANS (coreAudioFormatName), sampleRate_, numChannels_, bits),
+          writeFailed (true),
+          sampleFormat (getFileSampleFormat ((int) bits, isFloatingPoint)),
+          dither (options.dither ? new SampleConversion::DitherState() : nullptr),
+          destination (createDestinationFor (*out, options, sampleRate_, (int) (numChannels_ * bits / 8))),
+          headerStart (destination->getSize()),
+          bytesWritten (0),
+          durability (options),
+          staging (*this, (int) numChannels_, options.stagingSize)
+    {
+        usesFloatingPointData = true;
+
+        const bool isSupportedDepth = isFloatingPoint ? (bits == 32 || bits == 64)
+                                                      : (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+
+        if (isSupportedDepth && numChannels > 0)
+            writeFailed = ! writeHeader();
+    }
+
+    ~CafStreamingWriter()
+    {
+        if (! writeFailed && staging.flush())
         {
-            FileInputStream* newStream = new FileInputStream (fileCheck->getFile());
-            input = newStream;
-            DBG ("input stream opened: " << newStream->openedOk() << " - " << newStream->getStatus().getErrorMessage());
+            const int64 dataChunkSize = ByteOrder::swapIfLittleEndian ((uint64) (cafEditCountSize + bytesWritten));
+            destination->writeAt (headerStart + cafDataSizeOffset, &dataChunkSize, sizeof (dataChunkSize));
+            destination->flush();
         }
-        
-        MemoryOutputStream* memoryCheck = dynamic_cast<MemoryOutputStream*> (output);
-        if (memoryCheck != nullptr)
-            input = new MemoryInputStream (memoryCheck->getData(), memoryCheck->getDataSize(), false);
-        
-        DBG ("input stream size: " << (int) input->getTotalLength());
     }
-    
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreAudioWriter);
+
+    //==============================================================================
+    bool write (const int** data, int numSamples)
+    {
+        jassert (data != nullptr && *data != nullptr); // the input must contain at least one channel!
+
+        if (writeFailed)
+            return false;
+
+        return staging.write (reinterpret_cast<const float**> (data), numSamples);
+    }
+
+    /** Writes out any samples that are waiting in the staging buffer, and flushes
+        everything written so far through to the destination.
+    */
+    bool flush()
+    {
+        return ! writeFailed && staging.flush() && destination->flush();
+    }
+
+    bool isBypassingCache() const noexcept  { return destination->isBypassingCache(); }
+
+    /** Stops the base class deleting the stream, for when creating the writer fails. */
+    void releaseOutputStream() noexcept     { output = nullptr; }
+
+    bool writeFailed;
+
+private:
+    //==============================================================================
+    const SampleConversion::SampleFormat sampleFormat;
+    MemoryBlock interleavedData;
+    Array<const float*> channelList;
+    ScopedPointer<SampleConversion::DitherState> dither;
+    ScopedPointer<PositionalOutput> destination;
+    const int64 headerStart;
+    int64 bytesWritten;
+    DurabilityTracker durability;
+    StagingBuffer staging;      // where small blocks are gathered, so that the file gets fewer, bigger writes
+
+    enum
+    {
+        cafHeaderSize                           = 68,
+        cafDataSizeOffset                       = 56,
+        cafEditCountSize                        = 4,
+        cafLinearPCMFormatFlagIsFloat           = (1 << 0),
+        cafLinearPCMFormatFlagIsLittleEndian    = (1 << 1)
+    };
+
+    bool writeBlock (const float** channels, int numSamples)
+    {
+        const int bytesPerFrame = (int) (numChannels * bitsPerSample / 8);
+        const size_t numBytes = (size_t) (numSamples * bytesPerFrame);
+        interleavedData.ensureSize (numBytes, false);
+
+        SampleConversion::convertToInterleaved (getChannelList (reinterpret_cast<const int**> (channels), (int) numChannels, channelList),
+                                                (int) numChannels, interleavedData.getData(), sampleFormat, false,
+                                                numSamples, dither);
+
+        if (! destination->writeAt (headerStart + cafHeaderSize + bytesWritten, interleavedData.getData(), numBytes))
+        {
+            writeFailed = true;
+            return false;
+        }
+
+        bytesWritten += (int64) numBytes;
+        durability.noteBytesWritten (*destination, (int64) numBytes);
+        return true;
+    }
+
+    bool writeHeader()
+    {
+        MemoryOutputStream header ((size_t) cafHeaderSize);
+
+        header.write ("caff", 4);
+        header.writeShortBigEndian (1);     // file version
+        header.writeShortBigEndian (0);     // file flags
+
+        header.write ("desc", 4);
+        header.writeInt64BigEndian (32);
+        header.writeDoubleBigEndian (sampleRate);
+        header.write ("lpcm", 4);
+        header.writeIntBigEndian (cafLinearPCMFormatFlagIsLittleEndian
+                                   | (isFloatingPoint() ? cafLinearPCMFormatFlagIsFloat : 0));
+        header.writeIntBigEndian ((int) (numChannels * bitsPerSample / 8));    // bytes per packet
+        header.writeIntBigEndian (1);                                           // frames per packet
+        header.writeIntBigEndian ((int) numChannels);
+        header.writeIntBigEndian ((int) bitsPerSample);
+
+        header.write ("data", 4);
+        header.writeInt64BigEndian (-1);
+        header.writeIntBigEndian (0);       // edit count
+
+        jassert (header.getDataSize() == cafHeaderSize);
+        return destination->writeAt (headerStart, header.getData(), header.getDataSize());
+    }
+
+    bool isFloatingPoint() const noexcept
+    {
+        return sampleFormat == SampleConversion::float32Format || sampleFormat == SampleConversion::float64Format;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CafStreamingWriter);
 };
 
 //==============================================================================
 CoreAudioFormat::CoreAudioFormat()
-    : AudioFormat (TRANS (coreAudioFormatName), findFileExtensionsForCoreAudioCodecs())
+    : AudioFormat (TRANS (coreAudioFormatName), CodecRegistry::getInstance().extensions)
 {
 }
 
 CoreAudioFormat::~CoreAudioFormat() {}
 
-Array<int> CoreAudioFormat::getPossibleSampleRates()    { return Array<int>(); }
-Array<int> CoreAudioFormat::getPossibleBitDepths()      { return Array<int>(); }
+//==============================================================================
+CoreAudioFormat::WriterOptions::WriterOptions() noexcept
+    : fileType (waveFile),
+      stagingSize (4096),
+      shadowSize (64 * 1024),
+      durabilityPolicy (flushWhenClosed),
+      flushIntervalBytes (1024 * 1024),
+      growthPolicy (writeZeros),
+      expectedDurationSeconds (0),
+      outputMethod (positionalOutput),
+      dither (false)
+{
+}
+
+void CoreAudioFormat::setWriterOptions (const WriterOptions& newOptions)
+{
+    writerOptions = newOptions;
+}
+
+bool CoreAudioFormat::flushWriter (AudioFormatWriter* writer)
+{
+    if (CoreAudioWriter* const coreAudioWriter = dynamic_cast<CoreAudioWriter*> (writer))
+        return coreAudioWriter->flush();
+
+    if (CafStreamingWriter* const cafWriter = dynamic_cast<CafStreamingWriter*> (writer))
+        return cafWriter->flush();
+
+    return false;
+}
+
+bool CoreAudioFormat::isWriterBypassingCache (AudioFormatWriter* writer)
+{
+    if (CoreAudioWriter* const coreAudioWriter = dynamic_cast<CoreAudioWriter*> (writer))
+        return coreAudioWriter->isBypassingCache();
+
+    if (CafStreamingWriter* const cafWriter = dynamic_cast<CafStreamingWriter*> (writer))
+        return cafWriter->isBypassingCache();
+
+    return false;
+}
+
+//==============================================================================
+CoreAudioFormat::ReaderOptions::ReaderOptions() noexcept
+    : memoryBudgetBytes (1024 * 1024),
+      minimumChunkFrames (1024),
+      lengthCacheDirectory (File::nonexistent),
+      readAheadBytes (512 * 1024),
+      useSharedBlockCache (false)
+{
+}
+
+void CoreAudioFormat::setReaderOptions (const ReaderOptions& newOptions)
+{
+    readerOptions = newOptions;
+}
+
+CoreAudioFormat::ReaderStatistics::ReaderStatistics() noexcept
+    : numChunks (0),
+      numFramesDecoded (0),
+      numSeeks (0),
+      smallestChunk (0),
+      largestChunk (0)
+{
+}
+
+double CoreAudioFormat::ReaderStatistics::getAverageChunkSize() const noexcept
+{
+    return numChunks > 0 ? numFramesDecoded / (double) numChunks : 0.0;
+}
+
+bool CoreAudioFormat::getReaderStatistics (AudioFormatReader* reader, ReaderStatistics& result)
+{
+    if (CoreAudioReader* const coreAudioReader = dynamic_cast<CoreAudioReader*> (reader))
+    {
+        result = coreAudioReader->getStatistics();
+        return true;
+    }
+
+    return false;
+}
+
+CoreAudioFormat::FileInfo::FileInfo() noexcept
+    : numChannels (0),
+      sampleRate (0),
+      lengthInSamples (0),
+      bitsPerSample (0),
+      usesFloatingPointData (false)
+{
+}
+
+bool CoreAudioFormat::probe (InputStream& stream, FileInfo& result)
+{
+    const int64 originalPosition = stream.getPosition();
+    const int64 fileSize = stream.getTotalLength();
+    bool ok = false;
+
+    char header[12] = { 0 };
+    FileInfo info;
+
+    if (fileSize > 0 && stream.setPosition (0) && stream.read (header, sizeof (header)) == (int) sizeof (header))
+    {
+        if (chunkIdIs (header, "RIFF") && chunkIdIs (header + 8, "WAVE"))
+            ok = probeWaveFile (stream, fileSize, info);
+        else if (chunkIdIs (header, "caff") && ByteOrder::bigEndianShort (header + 4) == 1)
+            ok = probeCafFile (stream, fileSize, info);
+    }
+
+    stream.setPosition (originalPosition);
+
+    if (ok)
+        result = info;
+
+    return ok;
+}
+
+Array<int> CoreAudioFormat::getPossibleSampleRates()    { return CodecRegistry::getInstance().sampleRates; }
+Array<int> CoreAudioFormat::getPossibleBitDepths()      { return CodecRegistry::getInstance().bitDepths; }
 
 bool CoreAudioFormat::canDoStereo()     { return true; }
 bool CoreAudioFormat::canDoMono()       { return true; }
 
+StringArray CoreAudioFormat::getQualityOptions()
+{
+    StringArray options;
+    options.add ("Integer");
+    options.add ("Floating point");
+    return options;
+}
+
 //==============================================================================
 AudioFormatReader* CoreAudioFormat::createReaderFor (InputStream* sourceStream,
                                                      bool deleteStreamIfOpeningFails)
 {
-    ScopedPointer<CoreAudioReader> r (new CoreAudioReader (sourceStream));
+    if (! looksLikeAudioFile (*sourceStream))
+    {
+        if (deleteStreamIfOpeningFails)
+            delete sourceStream;
+
+        return nullptr;
+    }
+
+    ScopedPointer<CoreAudioReader> r (new CoreAudioReader (sourceStream, readerOptions));
 
     if (r->ok)
         return r.release();
@@ -548,12 +1683,53 @@ AudioFormatWriter* CoreAudioFormat::createWriterFor (OutputStream* streamToWrite
                                                      const StringPairArray& metadataValues,
                                                      int qualityOptionIndex)
 {
-    ScopedPointer<CoreAudioWriter> newWriter (new CoreAudioWriter (streamToWriteTo, sampleRateToUse, (int) numberOfChannels, bitsPerSample, metadataValues));
+    // there's no such thing as 64-bit integer PCM, so that always means doubles
+    const bool isFloatingPoint = bitsPerSample == 64 || (bitsPerSample == 32 && qualityOptionIndex == 1);
+
+    if (writerOptions.fileType == WriterOptions::streamingCafFile)
+    {
+        ScopedPointer<CafStreamingWriter> cafWriter (new CafStreamingWriter (streamToWriteTo, sampleRateToUse, numberOfChannels,
+                                                                             (unsigned int) bitsPerSample, isFloatingPoint, writerOptions));
+
+        if (! cafWriter->writeFailed)
+            return cafWriter.release();
+
+        cafWriter->releaseOutputStream();
+        return nullptr;
+    }
+
+    ScopedPointer<CoreAudioWriter> newWriter (new CoreAudioWriter (streamToWriteTo, sampleRateToUse, (int) numberOfChannels, bitsPerSample,
+                                                                   isFloatingPoint, metadataValues, writerOptions));
     if (newWriter != nullptr && ! newWriter->writeFailed)
         return newWriter.release();
-    
+
+    // the caller still owns the stream if we fail
+    newWriter->releaseOutputStream();
+    return nullptr;
+}
+
+MemoryMappedAudioFormatReader* CoreAudioFormat::createMemoryMappedReader (const File& file)
+{
+    if (FileInputStream* const fin = file.createInputStream())
+    {
+        if (! looksLikeAudioFile (*fin))
+        {
+            delete fin;
+            return nullptr;
+        }
+
+        // this reader only looks at the header, so there's nothing to read ahead for
+        ReaderOptions options (readerOptions);
+        options.readAheadBytes = 0;
+
+        CoreAudioReader reader (fin, options);
+        PcmLayout layout;
+
+        if (reader.ok && reader.lengthInSamples > 0 && reader.getPcmLayout (layout))
+            return new MemoryMappedCoreAudioReader (file, reader, layout);
+    }
+
     return nullptr;
 }
 
-#undef CoreAudioFormat
-#endif
\ No newline at end of file
+#undef CoreAudioFormat
\ No newline at end of file
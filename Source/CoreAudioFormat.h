@@ -13,16 +13,19 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 
-#if JUCE_MAC || JUCE_IOS
 #define CoreAudioFormat CoreAudioFormatNew
 
 //==============================================================================
 /**
-    OSX and iOS only - This uses the AudioToolbox framework to read any audio
+    On OSX and iOS this uses the AudioToolbox framework to read any audio
     format that the system has a codec for.
 
     This should be able to understand formats such as mp3, m4a, etc.
 
+    On other platforms the same reader and writer run on top of a portable
+    implementation of the AudioFile callbacks, which handles uncompressed
+    CAF and WAV files.
+
     @see AudioFormat
  */
 class JUCE_API  CoreAudioFormat     : public AudioFormat
@@ -41,10 +44,27 @@ public:
     bool canDoStereo();
     bool canDoMono();
 
+    /** Returns "Integer" and "Floating point", which createWriterFor() takes as its
+        qualityOptionIndex.
+    */
+    StringArray getQualityOptions();
+
     //==============================================================================
+    /** Creates a reader for a file that the decoder understands.
+
+        The first few bytes of the stream are checked before anything else is done, so
+        that files which plainly aren't audio are turned away without any decoder
+        being set up.
+    */
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
                                         bool deleteStreamIfOpeningFails);
 
+    /** Creates a writer for a linear PCM file.
+
+        Asking for 64 bits, or for 32 bits with the "Floating point" quality option,
+        makes a file of float samples. The incoming floats are then only interleaved,
+        without going through any conversion (doubles are just widened).
+    */
     AudioFormatWriter* createWriterFor (OutputStream* streamToWriteTo,
                                         double sampleRateToUse,
                                         unsigned int numberOfChannels,
@@ -52,12 +72,262 @@ public:
                                         const StringPairArray& metadataValues,
                                         int qualityOptionIndex);
 
+    /** Creates a reader that converts samples straight out of a memory-mapped view of
+        the file, without any calls into the decoder.
+
+        This works for uncompressed CAF and WAV files, and on OSX and iOS for any other
+        file of packed, interleaved linear PCM. It returns nullptr for anything else.
+        As with any MemoryMappedAudioFormatReader, call mapEntireFile() or
+        mapSectionOfFile() before reading from it.
+    */
+    MemoryMappedAudioFormatReader* createMemoryMappedReader (const File& file);
+
+    //==============================================================================
+    /** A description of an audio file, as found by probe(). */
+    struct FileInfo
+    {
+        FileInfo() noexcept;
+
+        String formatName;              /**< "WAV" or "CAF". */
+        unsigned int numChannels;
+        double sampleRate;
+        int64 lengthInSamples;
+        unsigned int bitsPerSample;     /**< The bits per sample in the file, or 0 for compressed data. */
+        bool usesFloatingPointData;     /**< True for float samples, and for compressed data. */
+    };
+
+    /** Describes a file from its headers, without creating a reader for it.
+
+        Only a few small chunk headers are read, so this is cheap enough to run on every
+        file in a folder. It understands linear PCM WAV files, and CAF files that are
+        either linear PCM or have a packet table. It returns false for anything else,
+        even if createReaderFor() could open it. The stream is left where it was.
+    */
+    static bool probe (InputStream& stream, FileInfo& result);
+
+    //==============================================================================
+    /** Settings that control how the writers created by this format do their I/O.
+
+        Changing these only affects writers created after the change.
+    */
+    struct WriterOptions
+    {
+        /** Creates a set of options with the default values. */
+        WriterOptions() noexcept;
+
+        /** The kinds of file the writers can produce. */
+        enum FileType
+        {
+            waveFile,           /**< A WAV file, written through the AudioFile encoder. */
+            streamingCafFile    /**< A linear PCM CAF file, written directly as one sequential stream. */
+        };
+
+        /** Says when the written data should be flushed through to the destination stream. */
+        enum DurabilityPolicy
+        {
+            flushWhenClosed,        /**< Only flush when the writer is deleted. */
+            flushAfterInterval,     /**< Flush each time flushIntervalBytes have been written. */
+            flushAfterEveryWrite    /**< Flush after every block that's written to the file. */
+        };
+
+        /** Says how the file is extended when the encoder asks for it to grow. */
+        enum GrowthPolicy
+        {
+            writeZeros,             /**< Write zeros into the new space. */
+            allocateSpace           /**< Have the file system allocate the space, without writing to it. */
+        };
+
+        /** The ways the writer can get its data into the destination. */
+        enum OutputMethod
+        {
+            positionalOutput,       /**< Write files with pwrite(), and other streams through the stream. */
+            memoryMappedOutput,     /**< Map the file into memory and copy the data straight into it. */
+            asynchronousOutput,     /**< Queue the writes and let io_uring or a background thread do them. */
+            directOutput            /**< Write in large aligned blocks that bypass the OS's file cache. */
+        };
+
+        /** The type of file to write. Default is waveFile.
+
+            A streamingCafFile is written with its data size marked as unknown, so that
+            recording never has to seek back. The size is filled in when the writer is
+            deleted if the stream allows it, which makes this a good choice for long
+            recordings. It supports 8, 16, 24 and 32-bit integer data, and 32 and 64-bit
+            floating point data.
+        */
+        FileType fileType;
+
+        /** The number of sample frames the writer gathers up before converting them and
+            passing them on to the file. Small blocks, like the ones that come from an
+            audio callback, are copied into a buffer of this size so the file only gets
+            big writes; blocks that are at least this big are passed straight through.
+            Both types of file are staged like this.
+            Use CoreAudioFormat::flushWriter() to push out a partly-filled buffer.
+            Set this to 0 to turn it off. Default is 4096.
+        */
+        int stagingSize;
+
+        /** The number of bytes at the start of the file that the writer keeps a copy of,
+            so that the encoder can re-read its headers without going back to the stream.
+            Default is 64K.
+        */
+        int shadowSize;
+
+        /** When to flush the output stream. Default is flushWhenClosed. */
+        DurabilityPolicy durabilityPolicy;
+
+        /** Used with flushAfterInterval. Default is 1MB. */
+        int64 flushIntervalBytes;
+
+        /** How to extend the file. Default is writeZeros.
+
+            allocateSpace only makes a difference when writing to a FileOutputStream on a
+            platform that supports it; other streams always have zeros written to them.
+        */
+        GrowthPolicy growthPolicy;
+
+        /** If this is more than zero, space for this many seconds of audio is reserved in
+            the file before anything is written, so that long recordings are laid out
+            contiguously. Any of it that isn't used is given back when the writer is
+            deleted. Default is 0.
+        */
+        double expectedDurationSeconds;
+
+        /** How to write to the destination. Default is positionalOutput.
+
+            memoryMappedOutput only works with FileOutputStreams, on platforms other than
+            Windows; anything else falls back to positionalOutput. Because the mapping is
+            grown in large steps it needs plenty of address space, so it's best kept
+            for 64-bit builds. Use allocateSpace with it if running out of disk space
+            mustn't crash the process.
+
+            asynchronousOutput also needs a FileOutputStream on a platform other than
+            Windows; on Windows the writes are done synchronously, as they would be with
+            positionalOutput. It's the one to use when several files are being recorded from the
+            same thread, as a slow disk or fsync on one of them won't hold up the rest.
+            Write errors are reported on a later call to write() rather than the one
+            that caused them.
+
+            directOutput is for very long recordings that won't be read back straight
+            away, so that they don't push everything else out of the file cache. It
+            also needs a FileOutputStream on a platform other than Windows. Use
+            isWriterBypassingCache() to check that it's really working.
+        */
+        OutputMethod outputMethod;
+
+        /** If true, triangular dither noise is added when samples are converted to 16
+            or 24-bit. Default is false.
+        */
+        bool dither;
+    };
+
+    /** Changes the options used for writers that this format creates. */
+    void setWriterOptions (const WriterOptions& newOptions);
+
+    /** Returns the options that writers will be created with. */
+    const WriterOptions& getWriterOptions() const noexcept      { return writerOptions; }
+
+    /** Makes a writer that this format created write out any samples it's holding on
+        to, and flush everything through to its destination.
+
+        Returns false if that fails, or if the writer didn't come from a CoreAudioFormat.
+    */
+    static bool flushWriter (AudioFormatWriter* writer);
+
+    /** Returns true if a writer that this format created is keeping its data out of the
+        OS's file cache, as WriterOptions::directOutput asks.
+
+        This can change to false part-way through a recording, if the file system turns
+        out to refuse the uncached writes. Returns false if the writer didn't come from
+        a CoreAudioFormat.
+    */
+    static bool isWriterBypassingCache (AudioFormatWriter* writer);
+
+    //==============================================================================
+    /** Settings that control how the readers created by this format decode. */
+    struct ReaderOptions
+    {
+        /** Creates a set of options with the default values. */
+        ReaderOptions() noexcept;
+
+        /** The most memory that a reader's decoding chunks may take up, across all of
+            its channels. This limits how big a chunk can get. Default is 1MB.
+        */
+        int memoryBudgetBytes;
+
+        /** The number of frames that a reader decodes at a time after a seek. Default is 1024.
+
+            Each time a reader carries on from where it left off, its chunk size doubles,
+            until it reaches the limit set by memoryBudgetBytes. That way, long sequential
+            reads are done in big chunks, while scrubbing around the file stays cheap.
+        */
+        int minimumChunkFrames;
+
+        /** A folder where readers keep a small file holding the length of each file they
+            open. Default is File::nonexistent, which turns this off.
+
+            Working out the length of a compressed file that has no packet table means
+            scanning all of it. When this is set, that's only done the first time a file
+            is opened; later readers of the same file take the length from its entry and
+            open it straight away. Only the length is kept, not the packet positions, so
+            this doesn't make jumping about the file any quicker. Only files opened
+            through a FileInputStream get entries.
+        */
+        File lengthCacheDirectory;
+
+        /** How far ahead of the parser a reader fetches a file in the background once
+            it's reading straight through it. Default is 512KB; 0 turns this off.
+
+            Readers always get the file from their stream in 64KB blocks, and keep a few
+            of those around so that jumping about the file doesn't mean a trip to the
+            stream for every little read. Files opened from memory are read directly.
+        */
+        int readAheadBytes;
+
+        /** If true, readers of files keep the blocks they decode in
+            DecodedBlockCache::getSharedInstance(), and look there before decoding.
+            Default is false.
+
+            Then when the same file is open in several readers at once, e.g. one
+            drawing a thumbnail and one playing it, each part of it only gets decoded
+            once. Only files opened through a FileInputStream use the cache.
+        */
+        bool useSharedBlockCache;
+    };
+
+    /** Changes the options used for readers that this format creates. */
+    void setReaderOptions (const ReaderOptions& newOptions);
+
+    /** Returns the options that readers will be created with. */
+    const ReaderOptions& getReaderOptions() const noexcept      { return readerOptions; }
+
+    /** Counts of what a reader has been doing. */
+    struct ReaderStatistics
+    {
+        ReaderStatistics() noexcept;
+
+        int64 numChunks;            /**< The number of chunks decoded. */
+        int64 numFramesDecoded;     /**< The total number of frames in those chunks. */
+        int64 numSeeks;             /**< The number of times a read didn't carry on from the last one. */
+        int smallestChunk;          /**< The smallest chunk decoded, in frames. */
+        int largestChunk;           /**< The largest chunk decoded, in frames. */
+
+        /** Returns the mean number of frames per chunk. */
+        double getAverageChunkSize() const noexcept;
+    };
+
+    /** Fills in the statistics for a reader that this format created.
+        Returns false if the reader didn't come from a CoreAudioFormat.
+    */
+    static bool getReaderStatistics (AudioFormatReader* reader, ReaderStatistics& result);
+
 private:
+    WriterOptions writerOptions;
+    ReaderOptions readerOptions;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreAudioFormat);
 };
 
 #undef CoreAudioFormat
-#endif
 
 
 #endif  // __COREAUDIOFORMAT_H_B57C53A__
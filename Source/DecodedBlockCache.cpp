@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    DecodedBlockCache.cpp
+    Created: 17 Oct 2026 6:12:05pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "DecodedBlockCache.h"
+#include "ConcurrencyHelpers.h"
+
+//==============================================================================
+namespace
+{
+    DecodedBlockCache* createSharedCache()   { return new DecodedBlockCache (64 * 1024 * 1024); }
+
+    LazySingleton<DecodedBlockCache> sharedCache (createSharedCache);
+}
+
+//==============================================================================
+struct DecodedBlockCache::Entry
+{
+    Entry (const String& key_, Block* block_)
+        : key (key_), block (block_), previous (nullptr), next (nullptr)
+    {
+    }
+
+    const String key;
+    Block::Ptr block;
+    Entry* previous;    // the entry that was used before this one
+    Entry* next;        // the entry that was used after this one
+
+    JUCE_DECLARE_NON_COPYABLE (Entry);
+};
+
+//==============================================================================
+DecodedBlockCache::Block::Block (int numChannels_, int numFrames_, bool isFloatingPoint_)
+    : data ((size_t) (numChannels_ * numFrames_)),
+      numChannels (numChannels_),
+      numFrames (numFrames_),
+      floatingPoint (isFloatingPoint_)
+{
+}
+
+int* DecodedBlockCache::Block::getChannel (int channel) const noexcept
+{
+    jassert (isPositiveAndBelow (channel, numChannels));
+    return data + channel * numFrames;
+}
+
+//==============================================================================
+DecodedBlockCache::Statistics::Statistics() noexcept
+    : numHits (0),
+      numMisses (0),
+      numEvictions (0),
+      numBytesUsed (0),
+      numBlocks (0)
+{
+}
+
+double DecodedBlockCache::Statistics::getHitRate() const noexcept
+{
+    const int64 numLookups = numHits + numMisses;
+    return numLookups > 0 ? numHits / (double) numLookups : 0.0;
+}
+
+//==============================================================================
+DecodedBlockCache::DecodedBlockCache (int64 maxBytes)
+    : leastRecentlyUsed (nullptr),
+      mostRecentlyUsed (nullptr),
+      maximumSize (maxBytes)
+{
+}
+
+DecodedBlockCache::~DecodedBlockCache()
+{
+    clear();
+}
+
+DecodedBlockCache& DecodedBlockCache::getSharedInstance()
+{
+    return sharedCache.get();
+}
+
+String DecodedBlockCache::getFileIdentity (const File& file)
+{
+    return file.getFullPathName()
+            + "|" + String (file.getSize())
+            + "|" + String (file.getLastModificationTime().toMilliseconds());
+}
+
+String DecodedBlockCache::makeKey (const String& fileIdentity, int64 blockIndex)
+{
+    return fileIdentity + "#" + String (blockIndex);
+}
+
+//==============================================================================
+DecodedBlockCache::Block::Ptr DecodedBlockCache::find (const String& fileIdentity, int64 blockIndex)
+{
+    const String key (makeKey (fileIdentity, blockIndex));
+    const ScopedLock sl (lock);
+
+    if (! entries.contains (key))
+    {
+        ++statistics.numMisses;
+        return Block::Ptr();
+    }
+
+    Entry* const entry = entries [key];
+    unlink (entry);
+    linkAsMostRecent (entry);
+
+    ++statistics.numHits;
+    return entry->block;
+}
+
+void DecodedBlockCache::add (const String& fileIdentity, int64 blockIndex, Block* block)
+{
+    jassert (block != nullptr);
+
+    const String key (makeKey (fileIdentity, blockIndex));
+    const ScopedLock sl (lock);
+
+    if (entries.contains (key))
+        remove (entries [key]);
+
+    Entry* const entry = new Entry (key, block);
+    entries.set (key, entry);
+    linkAsMostRecent (entry);
+
+    statistics.numBytesUsed += block->getSizeInBytes();
+    ++statistics.numBlocks;
+
+    trimToSize();
+}
+
+void DecodedBlockCache::clear()
+{
+    const ScopedLock sl (lock);
+
+    while (leastRecentlyUsed != nullptr)
+        remove (leastRecentlyUsed);
+}
+
+void DecodedBlockCache::setMaximumSize (int64 maxBytes)
+{
+    const ScopedLock sl (lock);
+    maximumSize = maxBytes;
+    trimToSize();
+}
+
+int64 DecodedBlockCache::getMaximumSize() const
+{
+    const ScopedLock sl (lock);
+    return maximumSize;
+}
+
+DecodedBlockCache::Statistics DecodedBlockCache::getStatistics() const
+{
+    const ScopedLock sl (lock);
+    return statistics;
+}
+
+//==============================================================================
+void DecodedBlockCache::unlink (Entry* entry) noexcept
+{
+    if (entry->previous != nullptr)     entry->previous->next = entry->next;
+    else                                leastRecentlyUsed = entry->next;
+
+    if (entry->next != nullptr)         entry->next->previous = entry->previous;
+    else                                mostRecentlyUsed = entry->previous;
+
+    entry->previous = entry->next = nullptr;
+}
+
+void DecodedBlockCache::linkAsMostRecent (Entry* entry) noexcept
+{
+    entry->previous = mostRecentlyUsed;
+    entry->next = nullptr;
+
+    if (mostRecentlyUsed != nullptr)
+        mostRecentlyUsed->next = entry;
+    else
+        leastRecentlyUsed = entry;
+
+    mostRecentlyUsed = entry;
+}
+
+void DecodedBlockCache::remove (Entry* entry)
+{
+    unlink (entry);
+    entries.remove (entry->key);
+
+    statistics.numBytesUsed -= entry->block->getSizeInBytes();
+    --statistics.numBlocks;
+
+    delete entry;
+}
+
+void DecodedBlockCache::trimToSize()
+{
+    while (statistics.numBytesUsed > maximumSize && leastRecentlyUsed != nullptr)
+    {
+        remove (leastRecentlyUsed);
+        ++statistics.numEvictions;
+    }
+}
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    DecodedBlockCache.h
+    Created: 17 Oct 2026 6:12:05pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __DECODEDBLOCKCACHE_H_3F6A9C21__
+#define __DECODEDBLOCKCACHE_H_3F6A9C21__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    Holds on to blocks of decoded samples, so that several readers of the same file
+    only decode each part of it once.
+
+    The samples are stored the way AudioFormatReader::readSamples() gives them out:
+    32 bits each, which are either floats or left-justified ints. Each block says
+    which, and it's up to whoever reads a block to check that it's the kind they want.
+
+    Blocks are looked up by a string that identifies the file and the block's index
+    within it. When the blocks take up more than the cache's maximum size, the ones
+    that were used longest ago are dropped. Blocks are reference-counted, so one
+    that's dropped stays valid for anyone who's still using it.
+
+    All the methods are thread-safe.
+
+    @see CoreAudioFormatNew
+*/
+class DecodedBlockCache
+{
+public:
+    //==============================================================================
+    /** Creates a cache that holds up to maxBytes of samples. */
+    explicit DecodedBlockCache (int64 maxBytes);
+
+    /** Destructor. */
+    ~DecodedBlockCache();
+
+    //==============================================================================
+    /** A block of planar 32-bit samples, which are either floats or left-justified ints. */
+    class Block  : public ReferenceCountedObject
+    {
+    public:
+        Block (int numChannels, int numFrames, bool isFloatingPoint);
+
+        int getNumChannels() const noexcept         { return numChannels; }
+        int getNumFrames() const noexcept           { return numFrames; }
+
+        /** Returns true if the samples are floats, or false if they're ints. */
+        bool isFloatingPoint() const noexcept       { return floatingPoint; }
+
+        /** Returns a channel's samples. For a floating point block, these are really floats. */
+        int* getChannel (int channel) const noexcept;
+
+        /** Returns the number of bytes of samples in the block. */
+        int64 getSizeInBytes() const noexcept       { return (int64) numChannels * numFrames * (int64) sizeof (int); }
+
+        typedef ReferenceCountedObjectPtr<Block> Ptr;
+
+    private:
+        HeapBlock<int> data;
+        const int numChannels, numFrames;
+        const bool floatingPoint;
+
+        JUCE_DECLARE_NON_COPYABLE (Block);
+    };
+
+    //==============================================================================
+    /** Looks for a block, returning nullptr if it isn't in the cache. */
+    Block::Ptr find (const String& fileIdentity, int64 blockIndex);
+
+    /** Adds a block to the cache, replacing any that's already there with the same key. */
+    void add (const String& fileIdentity, int64 blockIndex, Block* block);
+
+    /** Drops all the blocks. */
+    void clear();
+
+    /** Changes the most memory the blocks may take up, dropping some if needed. */
+    void setMaximumSize (int64 maxBytes);
+
+    /** Returns the most memory the blocks may take up. */
+    int64 getMaximumSize() const;
+
+    //==============================================================================
+    /** Counts of how the cache has been used. */
+    struct Statistics
+    {
+        Statistics() noexcept;
+
+        int64 numHits;          /**< The number of calls to find() that found a block. */
+        int64 numMisses;        /**< The number of calls to find() that didn't. */
+        int64 numEvictions;     /**< The number of blocks dropped to make room for others. */
+        int64 numBytesUsed;     /**< The size of the blocks in the cache now. */
+        int numBlocks;          /**< The number of blocks in the cache now. */
+
+        /** Returns the proportion of lookups that found a block, from 0 to 1. */
+        double getHitRate() const noexcept;
+    };
+
+    /** Returns a copy of the counters. */
+    Statistics getStatistics() const;
+
+    //==============================================================================
+    /** Returns the cache that's shared by the whole process. It starts off with a
+        maximum size of 64MB.
+    */
+    static DecodedBlockCache& getSharedInstance();
+
+    /** Returns a string that identifies a particular version of a file, made from its
+        path, size and modification time.
+    */
+    static String getFileIdentity (const File& file);
+
+private:
+    //==============================================================================
+    struct Entry;
+
+    CriticalSection lock;
+    HashMap<String, Entry*> entries;
+    Entry* leastRecentlyUsed;
+    Entry* mostRecentlyUsed;
+    int64 maximumSize;
+    Statistics statistics;
+
+    static String makeKey (const String& fileIdentity, int64 blockIndex);
+    void unlink (Entry*) noexcept;
+    void linkAsMostRecent (Entry*) noexcept;
+    void remove (Entry*);
+    void trimToSize();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedBlockCache);
+};
+
+
+#endif  // __DECODEDBLOCKCACHE_H_3F6A9C21__
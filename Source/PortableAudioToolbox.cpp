@@ -0,0 +1,1172 @@
+/*
+  ==============================================================================
+
+    PortableAudioToolbox.cpp
+    Created: 16 Oct 2026 10:12:41am
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "PortableAudioToolbox.h"
+#include "SampleConversion.h"
+
+#if ! (JUCE_MAC || JUCE_IOS)
+
+//==============================================================================
+namespace
+{
+    const AudioFileTypeID supportedFileTypes[] = { kAudioFileCAFType, kAudioFileWAVEType };
+
+    const int cafFileHeaderSize     = 8;
+    const int cafChunkHeaderSize    = 12;
+    const int cafDescChunkSize      = 32;
+    const int cafEditCountSize      = 4;
+
+    enum
+    {
+        cafLinearPCMFormatFlagIsFloat           = (1 << 0),
+        cafLinearPCMFormatFlagIsLittleEndian    = (1 << 1)
+    };
+
+    enum
+    {
+        waveFormatPCM           = 0x0001,
+        waveFormatIEEEFloat     = 0x0003,
+        waveFormatExtensible    = 0xfffe
+    };
+
+    // this is the tail of the KSDATAFORMAT_SUBTYPE GUIDs, which follows the two byte format tag
+    const uint8 waveSubFormatGuidTail[] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+    bool chunkIdIs (const void* data, const char* chunkId)
+    {
+        return memcmp (data, chunkId, 4) == 0;
+    }
+
+    bool isFloat (const AudioStreamBasicDescription& format) noexcept          { return (format.mFormatFlags & kAudioFormatFlagIsFloat) != 0; }
+    bool isBigEndian (const AudioStreamBasicDescription& format) noexcept      { return (format.mFormatFlags & kAudioFormatFlagIsBigEndian) != 0; }
+    bool isNonInterleaved (const AudioStreamBasicDescription& format) noexcept { return (format.mFormatFlags & kAudioFormatFlagIsNonInterleaved) != 0; }
+
+    /** Returns the number of bytes each sample of one channel takes up. */
+    int getBytesPerSample (const AudioStreamBasicDescription& format) noexcept
+    {
+        if (isNonInterleaved (format))
+            return (int) format.mBytesPerFrame;
+
+        return format.mChannelsPerFrame > 0 ? (int) (format.mBytesPerFrame / format.mChannelsPerFrame) : 0;
+    }
+
+    /** Maps a packed linear PCM file format onto the matching interleaved sample layout. */
+    SampleConversion::SampleFormat getSampleFormat (const AudioStreamBasicDescription& format) noexcept
+    {
+        switch (getBytesPerSample (format))
+        {
+            case 1:     return (format.mFormatFlags & kAudioFormatFlagIsSignedInteger) != 0 ? SampleConversion::int8Format
+                                                                                          : SampleConversion::uint8Format;
+            case 2:     return SampleConversion::int16Format;
+            case 3:     return SampleConversion::int24Format;
+            case 4:     return isFloat (format) ? SampleConversion::float32Format : SampleConversion::int32Format;
+            default:    break;
+        }
+
+        return SampleConversion::float64Format;
+    }
+
+    /** Checks that a file format is packed linear PCM in a sample type the converters know about. */
+    bool isSupportedFileFormat (const AudioStreamBasicDescription& format)
+    {
+        if (format.mFormatID != kAudioFormatLinearPCM
+             || format.mChannelsPerFrame == 0
+             || format.mFramesPerPacket != 1
+             || format.mSampleRate <= 0
+             || isNonInterleaved (format))
+            return false;
+
+        const int bytesPerSample = getBytesPerSample (format);
+
+        if (bytesPerSample * (int) format.mChannelsPerFrame != (int) format.mBytesPerFrame)
+            return false;
+
+        if (isFloat (format))
+            return bytesPerSample == 4 || bytesPerSample == 8;
+
+        return bytesPerSample >= 1 && bytesPerSample <= 4;
+    }
+
+    /** The client side of an ExtAudioFile must be native-endian 32-bit float or integer. */
+    bool isSupportedClientFormat (const AudioStreamBasicDescription& format)
+    {
+        return format.mFormatID == kAudioFormatLinearPCM
+                && format.mChannelsPerFrame > 0
+                && format.mBitsPerChannel == 32
+                && getBytesPerSample (format) == 4
+                && isBigEndian (format) == (kAudioFormatFlagsNativeEndian != 0)
+                && (isFloat (format) || (format.mFormatFlags & kAudioFormatFlagIsSignedInteger) != 0);
+    }
+
+    /** True if two formats lay their samples out identically, so data can be copied straight between them. */
+    bool isSameLayout (const AudioStreamBasicDescription& a, const AudioStreamBasicDescription& b) noexcept
+    {
+        const AudioFormatFlags flagsThatMatter = kAudioFormatFlagIsFloat | kAudioFormatFlagIsBigEndian
+                                                  | kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsNonInterleaved;
+
+        return a.mFormatID == b.mFormatID
+                && (a.mFormatFlags & flagsThatMatter) == (b.mFormatFlags & flagsThatMatter)
+                && a.mBitsPerChannel == b.mBitsPerChannel
+                && a.mChannelsPerFrame == b.mChannelsPerFrame
+                && a.mBytesPerFrame == b.mBytesPerFrame;
+    }
+
+    //==============================================================================
+    /** Converts a single channel between a file's interleaved data and a client buffer.
+        The client side is always native endian, and destStride/sourceStride are in samples.
+    */
+    template <class FileSampleType, class FileEndianness>
+    struct ChannelConverter
+    {
+        template <class ClientSampleType>
+        static void fromFile (void* dest, int destStride, const void* source, int numFileChannels, int numSamples)
+        {
+            AudioData::Pointer <ClientSampleType, AudioData::NativeEndian, AudioData::Interleaved, AudioData::NonConst> d (dest, destStride);
+            d.convertSamples (AudioData::Pointer <FileSampleType, FileEndianness, AudioData::Interleaved, AudioData::Const> (source, numFileChannels), numSamples);
+        }
+
+        template <class ClientSampleType>
+        static void toFile (void* dest, int numFileChannels, const void* source, int sourceStride, int numSamples)
+        {
+            AudioData::Pointer <FileSampleType, FileEndianness, AudioData::Interleaved, AudioData::NonConst> d (dest, numFileChannels);
+            d.convertSamples (AudioData::Pointer <ClientSampleType, AudioData::NativeEndian, AudioData::Interleaved, AudioData::Const> (source, sourceStride), numSamples);
+        }
+    };
+
+    // AudioData has no 64-bit float type, so doubles are dealt with by hand
+    double readDouble (const char* source, bool bigEndian) noexcept
+    {
+        union { uint64 asInt; double asDouble; } n;
+        n.asInt = bigEndian ? ByteOrder::bigEndianInt64 (source) : ByteOrder::littleEndianInt64 (source);
+        return n.asDouble;
+    }
+
+    void writeDouble (char* dest, double value, bool bigEndian) noexcept
+    {
+        union { uint64 asInt; double asDouble; } n;
+        n.asDouble = value;
+        n.asInt = bigEndian ? ByteOrder::swapIfLittleEndian (n.asInt) : ByteOrder::swapIfBigEndian (n.asInt);
+        memcpy (dest, &n.asInt, sizeof (n.asInt));
+    }
+
+    void convertChannelFromFile (const AudioStreamBasicDescription& fileFormat, const void* source,
+                                 bool clientIsFloat, void* dest, int destStride, int numSamples)
+    {
+        const int numFileChannels = (int) fileFormat.mChannelsPerFrame;
+        const bool bigEndian = isBigEndian (fileFormat);
+
+        #define JUCE_PORTABLE_FROM_FILE(FileType, Endianness) \
+            if (clientIsFloat)  ChannelConverter <AudioData::FileType, AudioData::Endianness>::fromFile <AudioData::Float32> (dest, destStride, source, numFileChannels, numSamples); \
+            else                ChannelConverter <AudioData::FileType, AudioData::Endianness>::fromFile <AudioData::Int32>   (dest, destStride, source, numFileChannels, numSamples);
+
+        switch (getBytesPerSample (fileFormat))
+        {
+            case 1:
+                if ((fileFormat.mFormatFlags & kAudioFormatFlagIsSignedInteger) != 0)   { JUCE_PORTABLE_FROM_FILE (Int8,  LittleEndian) }
+                else                                                                    { JUCE_PORTABLE_FROM_FILE (UInt8, LittleEndian) }
+                break;
+
+            case 2:
+                if (bigEndian)  { JUCE_PORTABLE_FROM_FILE (Int16, BigEndian) }
+                else            { JUCE_PORTABLE_FROM_FILE (Int16, LittleEndian) }
+                break;
+
+            case 3:
+                if (bigEndian)  { JUCE_PORTABLE_FROM_FILE (Int24, BigEndian) }
+                else            { JUCE_PORTABLE_FROM_FILE (Int24, LittleEndian) }
+                break;
+
+            case 4:
+                if (isFloat (fileFormat))
+                {
+                    if (bigEndian)  { JUCE_PORTABLE_FROM_FILE (Float32, BigEndian) }
+                    else            { JUCE_PORTABLE_FROM_FILE (Float32, LittleEndian) }
+                }
+                else
+                {
+                    if (bigEndian)  { JUCE_PORTABLE_FROM_FILE (Int32, BigEndian) }
+                    else            { JUCE_PORTABLE_FROM_FILE (Int32, LittleEndian) }
+                }
+                break;
+
+            case 8:
+            {
+                const char* s = static_cast<const char*> (source);
+                const int sourceStride = 8 * numFileChannels;
+
+                if (clientIsFloat)
+                {
+                    float* d = static_cast<float*> (dest);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        d[i * destStride] = (float) readDouble (s + i * sourceStride, bigEndian);
+                }
+                else
+                {
+                    int* d = static_cast<int*> (dest);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        d[i * destStride] = (int) (jlimit (-1.0, 1.0, readDouble (s + i * sourceStride, bigEndian)) * (double) 0x7fffffff);
+                }
+
+                break;
+            }
+
+            default:
+                jassertfalse;
+                break;
+        }
+
+        #undef JUCE_PORTABLE_FROM_FILE
+    }
+
+    void convertChannelToFile (const AudioStreamBasicDescription& fileFormat, void* dest,
+                               bool clientIsFloat, const void* source, int sourceStride, int numSamples)
+    {
+        const int numFileChannels = (int) fileFormat.mChannelsPerFrame;
+        const bool bigEndian = isBigEndian (fileFormat);
+
+        #define JUCE_PORTABLE_TO_FILE(FileType, Endianness) \
+            if (clientIsFloat)  ChannelConverter <AudioData::FileType, AudioData::Endianness>::toFile <AudioData::Float32> (dest, numFileChannels, source, sourceStride, numSamples); \
+            else                ChannelConverter <AudioData::FileType, AudioData::Endianness>::toFile <AudioData::Int32>   (dest, numFileChannels, source, sourceStride, numSamples);
+
+        switch (getBytesPerSample (fileFormat))
+        {
+            case 1:
+                if ((fileFormat.mFormatFlags & kAudioFormatFlagIsSignedInteger) != 0)   { JUCE_PORTABLE_TO_FILE (Int8,  LittleEndian) }
+                else                                                                    { JUCE_PORTABLE_TO_FILE (UInt8, LittleEndian) }
+                break;
+
+            case 2:
+                if (bigEndian)  { JUCE_PORTABLE_TO_FILE (Int16, BigEndian) }
+                else            { JUCE_PORTABLE_TO_FILE (Int16, LittleEndian) }
+                break;
+
+            case 3:
+                if (bigEndian)  { JUCE_PORTABLE_TO_FILE (Int24, BigEndian) }
+                else            { JUCE_PORTABLE_TO_FILE (Int24, LittleEndian) }
+                break;
+
+            case 4:
+                if (isFloat (fileFormat))
+                {
+                    if (bigEndian)  { JUCE_PORTABLE_TO_FILE (Float32, BigEndian) }
+                    else            { JUCE_PORTABLE_TO_FILE (Float32, LittleEndian) }
+                }
+                else
+                {
+                    if (bigEndian)  { JUCE_PORTABLE_TO_FILE (Int32, BigEndian) }
+                    else            { JUCE_PORTABLE_TO_FILE (Int32, LittleEndian) }
+                }
+                break;
+
+            case 8:
+            {
+                char* d = static_cast<char*> (dest);
+                const int destStride = 8 * numFileChannels;
+
+                if (clientIsFloat)
+                {
+                    const float* s = static_cast<const float*> (source);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        writeDouble (d + i * destStride, (double) s[i * sourceStride], bigEndian);
+                }
+                else
+                {
+                    const int* s = static_cast<const int*> (source);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        writeDouble (d + i * destStride, s[i * sourceStride] / (double) 0x7fffffff, bigEndian);
+                }
+
+                break;
+            }
+
+            default:
+                jassertfalse;
+                break;
+        }
+
+        #undef JUCE_PORTABLE_TO_FILE
+    }
+}
+
+//==============================================================================
+struct OpaqueAudioFileID
+{
+    OpaqueAudioFileID (void* clientData_,
+                       AudioFile_ReadProc readProc_, AudioFile_WriteProc writeProc_,
+                       AudioFile_GetSizeProc getSizeProc_, AudioFile_SetSizeProc setSizeProc_,
+                       AudioFileTypeID fileType_)
+        : clientData (clientData_),
+          readProc (readProc_), writeProc (writeProc_),
+          getSizeProc (getSizeProc_), setSizeProc (setSizeProc_),
+          fileType (fileType_),
+          dataOffset (0), dataSize (0),
+          isWritable (false), headerNeedsUpdating (false)
+    {
+        zerostruct (format);
+    }
+
+    //==============================================================================
+    OSStatus open()
+    {
+        if (readProc == nullptr || getSizeProc == nullptr)
+            return kAudioFileNotOpenError;
+
+        char header[12];
+        UInt32 numRead = 0;
+        OSStatus status = readBytes (0, sizeof (header), header, numRead);
+
+        if (status != noErr)
+            return status;
+
+        if (numRead < cafFileHeaderSize)
+            return kAudioFileUnsupportedFileTypeError;
+
+        if (chunkIdIs (header, "caff"))
+        {
+            fileType = kAudioFileCAFType;
+            status = parseCafHeader (header);
+        }
+        else if (numRead == sizeof (header) && chunkIdIs (header, "RIFF") && chunkIdIs (header + 8, "WAVE"))
+        {
+            fileType = kAudioFileWAVEType;
+            status = parseWaveHeader();
+        }
+        else
+        {
+            return kAudioFileUnsupportedFileTypeError;
+        }
+
+        if (status == noErr && ! isSupportedFileFormat (format))
+            status = kAudioFileUnsupportedDataFormatError;
+
+        isWritable = false; // opening existing files for writing isn't supported
+        return status;
+    }
+
+    OSStatus initialise (const AudioStreamBasicDescription& newFormat)
+    {
+        if (writeProc == nullptr)
+            return kAudioFilePermissionsError;
+
+        if (fileType != kAudioFileWAVEType && fileType != kAudioFileCAFType)
+            return kAudioFileUnsupportedFileTypeError;
+
+        format = newFormat;
+        format.mFormatFlags &= ~(UInt32) kAudioFormatFlagIsNonInterleaved;
+
+        if (! isSupportedFileFormat (format))
+            return kAudioFileUnsupportedDataFormatError;
+
+        if (fileType == kAudioFileWAVEType)
+        {
+            // WAV files are little-endian, with unsigned 8-bit and signed 16-32 bit integers
+            if (isBigEndian (format))
+                return kAudioFileUnsupportedDataFormatError;
+
+            if (! isFloat (format))
+            {
+                if (format.mBytesPerFrame == format.mChannelsPerFrame)
+                    format.mFormatFlags &= ~(UInt32) kAudioFormatFlagIsSignedInteger;
+                else
+                    format.mFormatFlags |= kAudioFormatFlagIsSignedInteger;
+            }
+        }
+        else if (! isFloat (format))
+        {
+            // CAF integer data is always signed
+            format.mFormatFlags |= kAudioFormatFlagIsSignedInteger;
+        }
+
+        isWritable = true;
+        dataSize = 0;
+
+        MemoryOutputStream header;
+        createHeader (header, false);
+        dataOffset = (int64) header.getDataSize();
+
+        return writeBytes (0, (UInt32) header.getDataSize(), header.getData());
+    }
+
+    OSStatus close()
+    {
+        if (! (isWritable && headerNeedsUpdating))
+            return noErr;
+
+        headerNeedsUpdating = false;
+
+        MemoryOutputStream header;
+        createHeader (header, true);
+        jassert ((int64) header.getDataSize() == dataOffset);
+
+        OSStatus status = writeBytes (0, (UInt32) header.getDataSize(), header.getData());
+
+        // RIFF chunks are padded to an even length
+        if (status == noErr && fileType == kAudioFileWAVEType && (dataSize & 1) != 0)
+        {
+            const char padByte = 0;
+            status = writeBytes (dataOffset + dataSize, 1, &padByte);
+        }
+
+        return status;
+    }
+
+    //==============================================================================
+    OSStatus readBytes (SInt64 position, UInt32 numBytes, void* dest, UInt32& actualCount)
+    {
+        actualCount = 0;
+
+        if (readProc == nullptr)
+            return kAudioFilePermissionsError;
+
+        return readProc (clientData, position, numBytes, dest, &actualCount);
+    }
+
+    OSStatus writeBytes (SInt64 position, UInt32 numBytes, const void* source)
+    {
+        if (writeProc == nullptr)
+            return kAudioFilePermissionsError;
+
+        UInt32 actualCount = 0;
+        const OSStatus status = writeProc (clientData, position, numBytes, source, &actualCount);
+
+        if (status != noErr)
+            return status;
+
+        return actualCount == numBytes ? noErr : kAudioFileUnspecifiedError;
+    }
+
+    /** Writes some frames of file-format data at the given frame position. */
+    OSStatus writeFrames (int64 framePosition, int numFrames, const void* source)
+    {
+        const int64 startByte = framePosition * format.mBytesPerFrame;
+        const UInt32 numBytes = (UInt32) numFrames * format.mBytesPerFrame;
+        const OSStatus status = writeBytes (dataOffset + startByte, numBytes, source);
+
+        if (status == noErr)
+        {
+            dataSize = jmax (dataSize, startByte + (int64) numBytes);
+            headerNeedsUpdating = true;
+        }
+
+        return status;
+    }
+
+    int64 getLengthInFrames() const noexcept
+    {
+        return format.mBytesPerFrame > 0 ? dataSize / format.mBytesPerFrame : 0;
+    }
+
+    //==============================================================================
+    void* clientData;
+    AudioFile_ReadProc readProc;
+    AudioFile_WriteProc writeProc;
+    AudioFile_GetSizeProc getSizeProc;
+    AudioFile_SetSizeProc setSizeProc;
+
+    AudioFileTypeID fileType;
+    AudioStreamBasicDescription format;
+    int64 dataOffset, dataSize;
+    bool isWritable, headerNeedsUpdating;
+
+private:
+    //==============================================================================
+    OSStatus parseWaveHeader()
+    {
+        const int64 fileSize = getSizeProc (clientData);
+        int64 position = 12;
+        bool foundFormat = false;
+
+        while (position + 8 <= fileSize)
+        {
+            char chunkHeader[8];
+            UInt32 numRead = 0;
+            OSStatus status = readBytes (position, sizeof (chunkHeader), chunkHeader, numRead);
+
+            if (status != noErr || numRead != sizeof (chunkHeader))
+                break;
+
+            const int64 chunkSize = (int64) ByteOrder::littleEndianInt (chunkHeader + 4);
+            const int64 chunkStart = position + 8;
+
+            if (chunkIdIs (chunkHeader, "fmt "))
+            {
+                uint8 fmt[40] = { 0 };
+                status = readBytes (chunkStart, (UInt32) jmin ((int64) sizeof (fmt), chunkSize), fmt, numRead);
+
+                if (status != noErr || numRead < 16)
+                    return kAudioFileInvalidFileError;
+
+                int formatTag = ByteOrder::littleEndianShort (fmt);
+
+                if (formatTag == waveFormatExtensible && numRead >= 26)
+                    formatTag = ByteOrder::littleEndianShort (fmt + 24);
+
+                if (formatTag != waveFormatPCM && formatTag != waveFormatIEEEFloat)
+                    return kAudioFileUnsupportedDataFormatError;
+
+                const int numChannels = ByteOrder::littleEndianShort (fmt + 2);
+                const int blockAlign  = ByteOrder::littleEndianShort (fmt + 12);
+
+                format.mSampleRate       = (Float64) ByteOrder::littleEndianInt (fmt + 4);
+                format.mFormatID         = kAudioFormatLinearPCM;
+                format.mFormatFlags      = kAudioFormatFlagIsPacked;
+                format.mChannelsPerFrame = (UInt32) numChannels;
+                format.mBytesPerFrame    = (UInt32) blockAlign;
+                format.mFramesPerPacket  = 1;
+                format.mBytesPerPacket   = format.mBytesPerFrame;
+                format.mBitsPerChannel   = numChannels > 0 ? (UInt32) (8 * blockAlign / numChannels) : 0;
+
+                if (formatTag == waveFormatIEEEFloat)
+                    format.mFormatFlags |= kAudioFormatFlagIsFloat;
+                else if (format.mBitsPerChannel > 8)
+                    format.mFormatFlags |= kAudioFormatFlagIsSignedInteger;
+
+                foundFormat = true;
+            }
+            else if (chunkIdIs (chunkHeader, "data"))
+            {
+                if (! foundFormat)
+                    return kAudioFileInvalidFileError;
+
+                dataOffset = chunkStart;
+
+                // recorders that never finished writing leave the size empty or wrong
+                dataSize = (chunkSize == 0 || chunkStart + chunkSize > fileSize) ? fileSize - chunkStart
+                                                                                 : chunkSize;
+                return noErr;
+            }
+
+            position = chunkStart + chunkSize + (chunkSize & 1);
+        }
+
+        return kAudioFileInvalidFileError;
+    }
+
+    OSStatus parseCafHeader (const char* fileHeader)
+    {
+        if (ByteOrder::bigEndianShort (fileHeader + 4) != 1)
+            return kAudioFileUnsupportedFileTypeError;
+
+        const int64 fileSize = getSizeProc (clientData);
+        int64 position = cafFileHeaderSize;
+        bool foundFormat = false;
+
+        while (position + cafChunkHeaderSize <= fileSize)
+        {
+            char chunkHeader[cafChunkHeaderSize];
+            UInt32 numRead = 0;
+            OSStatus status = readBytes (position, sizeof (chunkHeader), chunkHeader, numRead);
+
+            if (status != noErr || numRead != sizeof (chunkHeader))
+                break;
+
+            const int64 chunkSize = (int64) ByteOrder::bigEndianInt64 (chunkHeader + 4);
+            const int64 chunkStart = position + cafChunkHeaderSize;
+
+            if (chunkIdIs (chunkHeader, "desc"))
+            {
+                char desc[cafDescChunkSize];
+                status = readBytes (chunkStart, sizeof (desc), desc, numRead);
+
+                if (status != noErr || numRead != sizeof (desc))
+                    return kAudioFileInvalidFileError;
+
+                const UInt32 cafFlags = ByteOrder::bigEndianInt (desc + 12);
+
+                format.mSampleRate       = readDouble (desc, true);
+                format.mFormatID         = ByteOrder::bigEndianInt (desc + 8);
+                format.mFormatFlags      = kAudioFormatFlagIsPacked;
+                format.mBytesPerPacket   = ByteOrder::bigEndianInt (desc + 16);
+                format.mFramesPerPacket  = ByteOrder::bigEndianInt (desc + 20);
+                format.mChannelsPerFrame = ByteOrder::bigEndianInt (desc + 24);
+                format.mBitsPerChannel   = ByteOrder::bigEndianInt (desc + 28);
+                format.mBytesPerFrame    = format.mBytesPerPacket;
+
+                if ((cafFlags & cafLinearPCMFormatFlagIsFloat) != 0)
+                    format.mFormatFlags |= kAudioFormatFlagIsFloat;
+                else
+                    format.mFormatFlags |= kAudioFormatFlagIsSignedInteger;
+
+                if ((cafFlags & cafLinearPCMFormatFlagIsLittleEndian) == 0)
+                    format.mFormatFlags |= kAudioFormatFlagIsBigEndian;
+
+                foundFormat = true;
+            }
+            else if (chunkIdIs (chunkHeader, "data"))
+            {
+                if (! foundFormat)
+                    return kAudioFileInvalidFileError;
+
+                dataOffset = chunkStart + cafEditCountSize;
+
+                // a size of -1 means the data runs to the end of the file, and so does one that's
+                // too big to fit in it. (This is compared with what's left so that it can't overflow)
+                const bool isSizeKnown = chunkSize >= cafEditCountSize && chunkSize <= fileSize - chunkStart;
+                dataSize = isSizeKnown ? chunkSize - cafEditCountSize
+                                       : jmax ((int64) 0, fileSize - dataOffset);
+                return noErr;
+            }
+
+            // a corrupt size could overflow the position or send it backwards
+            if (chunkSize < 0 || chunkSize > fileSize - chunkStart)
+                break;
+
+            position = chunkStart + chunkSize;
+        }
+
+        return kAudioFileInvalidFileError;
+    }
+
+    //==============================================================================
+    void createHeader (MemoryOutputStream& out, bool isFinished) const
+    {
+        if (fileType == kAudioFileCAFType)
+            createCafHeader (out, isFinished);
+        else
+            createWaveHeader (out);
+    }
+
+    void createWaveHeader (MemoryOutputStream& out) const
+    {
+        const bool isExtensible = format.mChannelsPerFrame > 2;
+        const int formatTag = isFloat (format) ? waveFormatIEEEFloat : waveFormatPCM;
+        const int formatChunkSize = isExtensible ? 40 : 16;
+        const int64 riffSize = 4 + (8 + formatChunkSize) + 8 + dataSize + (dataSize & 1);
+
+        out.write ("RIFF", 4);
+        out.writeInt ((int) jmin (riffSize, (int64) 0xffffffff));
+        out.write ("WAVE", 4);
+
+        out.write ("fmt ", 4);
+        out.writeInt (formatChunkSize);
+        out.writeShort ((short) (isExtensible ? waveFormatExtensible : formatTag));
+        out.writeShort ((short) format.mChannelsPerFrame);
+        out.writeInt ((int) format.mSampleRate);
+        out.writeInt ((int) (format.mSampleRate * format.mBytesPerFrame));
+        out.writeShort ((short) format.mBytesPerFrame);
+        out.writeShort ((short) (8 * getBytesPerSample (format)));
+
+        if (isExtensible)
+        {
+            const int channelMask = format.mChannelsPerFrame < 18 ? (1 << format.mChannelsPerFrame) - 1 : 0;
+
+            out.writeShort (22);
+            out.writeShort ((short) (8 * getBytesPerSample (format)));
+            out.writeInt (channelMask);
+            out.writeShort ((short) formatTag);
+            out.write (waveSubFormatGuidTail, sizeof (waveSubFormatGuidTail));
+        }
+
+        out.write ("data", 4);
+        out.writeInt ((int) jmin (dataSize, (int64) 0xffffffff));
+    }
+
+    void createCafHeader (MemoryOutputStream& out, bool isFinished) const
+    {
+        UInt32 cafFlags = 0;
+
+        if (isFloat (format))           cafFlags |= cafLinearPCMFormatFlagIsFloat;
+        if (! isBigEndian (format))     cafFlags |= cafLinearPCMFormatFlagIsLittleEndian;
+
+        out.write ("caff", 4);
+        out.writeShortBigEndian (1);
+        out.writeShortBigEndian (0);
+
+        out.write ("desc", 4);
+        out.writeInt64BigEndian (cafDescChunkSize);
+        out.writeDoubleBigEndian (format.mSampleRate);
+        out.writeIntBigEndian ((int) format.mFormatID);
+        out.writeIntBigEndian ((int) cafFlags);
+        out.writeIntBigEndian ((int) format.mBytesPerPacket);
+        out.writeIntBigEndian ((int) format.mFramesPerPacket);
+        out.writeIntBigEndian ((int) format.mChannelsPerFrame);
+        out.writeIntBigEndian ((int) format.mBitsPerChannel);
+
+        // until the file is closed the data size is unknown, which CAF allows for with -1
+        out.write ("data", 4);
+        out.writeInt64BigEndian (isFinished ? dataSize + cafEditCountSize : -1);
+        out.writeIntBigEndian (0);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (OpaqueAudioFileID);
+};
+
+//==============================================================================
+struct OpaqueExtAudioFile
+{
+    OpaqueExtAudioFile (AudioFileID file_)
+        : file (file_), framePosition (0), numClientChannelsAllocated (0)
+    {
+        // until told otherwise, the client gets non-interleaved floats
+        clientFormat = file->format;
+        clientFormat.mFormatFlags       = kAudioFormatFlagIsFloat | kAudioFormatFlagIsNonInterleaved | kAudioFormatFlagsNativeEndian;
+        clientFormat.mBitsPerChannel    = sizeof (float) * 8;
+        clientFormat.mBytesPerFrame     = sizeof (float);
+        clientFormat.mBytesPerPacket    = sizeof (float);
+        clientFormat.mFramesPerPacket   = 1;
+    }
+
+    //==============================================================================
+    OSStatus read (UInt32& numFrames, AudioBufferList& buffers)
+    {
+        int numToRead = (int) jmin ((int64) numFrames, file->getLengthInFrames() - framePosition);
+        numToRead = jmin (numToRead, getMaxFramesInBuffers (buffers));
+        numFrames = 0;
+
+        const int fileBytesPerFrame = (int) file->format.mBytesPerFrame;
+
+        while (numToRead > 0)
+        {
+            const int numThisTime = jmin (numToRead, (int) maxFramesPerBlock);
+            const UInt32 numBytes = (UInt32) (numThisTime * fileBytesPerFrame);
+            fileBlock.ensureSize (numBytes, false);
+
+            UInt32 numRead = 0;
+            const OSStatus status = file->readBytes (file->dataOffset + framePosition * fileBytesPerFrame,
+                                                     numBytes, fileBlock.getData(), numRead);
+            if (status != noErr)
+                return status;
+
+            const int numFramesRead = (int) numRead / fileBytesPerFrame;
+
+            if (numFramesRead <= 0)
+                break;
+
+            convertFromFile (buffers, (int) numFrames, numFramesRead);
+
+            numFrames += (UInt32) numFramesRead;
+            framePosition += numFramesRead;
+            numToRead -= numFramesRead;
+        }
+
+        setBufferSizes (buffers, (int) numFrames);
+        return noErr;
+    }
+
+    OSStatus write (UInt32 numFrames, const AudioBufferList& buffers)
+    {
+        if (! file->isWritable)
+            return kAudioFilePermissionsError;
+
+        int numToWrite = jmin ((int) numFrames, getMaxFramesInBuffers (buffers));
+        int startFrame = 0;
+
+        while (numToWrite > 0)
+        {
+            const int numThisTime = jmin (numToWrite, (int) maxFramesPerBlock);
+            const void* data = addBytesToPointer (buffers.mBuffers[0].mData, startFrame * (int) file->format.mBytesPerFrame);
+
+            // a client that supplies data in the file's own format has it written as it is
+            if (! isSameLayout (clientFormat, file->format))
+            {
+                fileBlock.ensureSize ((size_t) (numThisTime * (int) file->format.mBytesPerFrame), false);
+                convertToFile (buffers, startFrame, numThisTime);
+                data = fileBlock.getData();
+            }
+
+            const OSStatus status = file->writeFrames (framePosition, numThisTime, data);
+
+            if (status != noErr)
+                return status;
+
+            framePosition += numThisTime;
+            startFrame += numThisTime;
+            numToWrite -= numThisTime;
+        }
+
+        return noErr;
+    }
+
+    OSStatus setClientFormat (const AudioStreamBasicDescription& newFormat)
+    {
+        if (newFormat.mFormatID != kAudioFormatLinearPCM)
+            return kExtAudioFileError_NonPCMClientFormat;
+
+        if (! (isSupportedClientFormat (newFormat) || isSameLayout (newFormat, file->format))
+             || (newFormat.mSampleRate > 0 && newFormat.mSampleRate != file->format.mSampleRate))
+            return kExtAudioFileError_InvalidDataFormat;
+
+        clientFormat = newFormat;
+        return noErr;
+    }
+
+    //==============================================================================
+    AudioFileID file;
+    AudioStreamBasicDescription clientFormat;
+    int64 framePosition;
+
+private:
+    enum { maxFramesPerBlock = 4096 };
+    MemoryBlock fileBlock;
+    HeapBlock<const float*> clientChannels;
+    int numClientChannelsAllocated;
+
+    int getNumClientChannels (const AudioBufferList& buffers) const noexcept
+    {
+        return isNonInterleaved (clientFormat) ? jmin ((int) clientFormat.mChannelsPerFrame, (int) buffers.mNumberBuffers)
+                                               : (int) clientFormat.mChannelsPerFrame;
+    }
+
+    int getMaxFramesInBuffers (const AudioBufferList& buffers) const noexcept
+    {
+        if (buffers.mNumberBuffers == 0)
+            return 0;
+
+        int maxFrames = 0x7fffffff;
+
+        for (int i = (int) buffers.mNumberBuffers; --i >= 0;)
+            if (buffers.mBuffers[i].mData != nullptr)
+                maxFrames = jmin (maxFrames, (int) (buffers.mBuffers[i].mDataByteSize / clientFormat.mBytesPerFrame));
+
+        return maxFrames;
+    }
+
+    void setBufferSizes (AudioBufferList& buffers, int numFrames) const noexcept
+    {
+        for (int i = (int) buffers.mNumberBuffers; --i >= 0;)
+            buffers.mBuffers[i].mDataByteSize = (UInt32) numFrames * clientFormat.mBytesPerFrame;
+    }
+
+    /** Returns where a client channel's samples start, and the distance between them. */
+    void* getClientChannel (const AudioBufferList& buffers, int channel, int frameOffset, int& stride) const noexcept
+    {
+        if (isNonInterleaved (clientFormat))
+        {
+            stride = 1;
+            void* data = buffers.mBuffers[channel].mData;
+            return data != nullptr ? addBytesToPointer (data, frameOffset * (int) sizeof (float)) : nullptr;
+        }
+
+        stride = (int) clientFormat.mChannelsPerFrame;
+        return addBytesToPointer (buffers.mBuffers[0].mData, (frameOffset * stride + channel) * (int) sizeof (float));
+    }
+
+    void convertFromFile (AudioBufferList& buffers, int frameOffset, int numFrames)
+    {
+        if (isSameLayout (clientFormat, file->format))
+        {
+            const int fileBytesPerFrame = (int) file->format.mBytesPerFrame;
+            memcpy (addBytesToPointer (buffers.mBuffers[0].mData, frameOffset * fileBytesPerFrame),
+                    fileBlock.getData(), (size_t) (numFrames * fileBytesPerFrame));
+            return;
+        }
+
+        const int numFileChannels = (int) file->format.mChannelsPerFrame;
+        const int bytesPerSample = getBytesPerSample (file->format);
+        const bool clientIsFloat = isFloat (clientFormat);
+
+        for (int i = getNumClientChannels (buffers); --i >= 0;)
+        {
+            int stride;
+            void* dest = getClientChannel (buffers, i, frameOffset, stride);
+
+            if (dest == nullptr)
+                continue;
+
+            if (i < numFileChannels)
+            {
+                convertChannelFromFile (file->format, addBytesToPointer (fileBlock.getData(), i * bytesPerSample),
+                                        clientIsFloat, dest, stride, numFrames);
+            }
+            else
+            {
+                for (int j = 0; j < numFrames; ++j)
+                    static_cast<int*> (dest)[j * stride] = 0;
+            }
+        }
+    }
+
+    void convertToFile (const AudioBufferList& buffers, int frameOffset, int numFrames)
+    {
+        const int numFileChannels = (int) file->format.mChannelsPerFrame;
+        const int bytesPerSample = getBytesPerSample (file->format);
+        const int numClientChannels = getNumClientChannels (buffers);
+        const bool clientIsFloat = isFloat (clientFormat);
+
+        if (clientIsFloat && isNonInterleaved (clientFormat))
+        {
+            // planar float is the common case, so all channels get converted and interleaved together
+            if (numClientChannelsAllocated < numFileChannels)
+            {
+                clientChannels.malloc ((size_t) numFileChannels);
+                numClientChannelsAllocated = numFileChannels;
+            }
+
+            for (int i = 0; i < numFileChannels; ++i)
+            {
+                int stride;
+                clientChannels[i] = i < numClientChannels ? static_cast<const float*> (getClientChannel (buffers, i, frameOffset, stride))
+                                                          : nullptr;
+            }
+
+            SampleConversion::convertToInterleaved (clientChannels, numFileChannels, fileBlock.getData(),
+                                                    getSampleFormat (file->format), isBigEndian (file->format), numFrames);
+            return;
+        }
+
+        for (int i = 0; i < numFileChannels; ++i)
+        {
+            int stride = 1;
+            const void* source = i < numClientChannels ? getClientChannel (buffers, i, frameOffset, stride) : nullptr;
+            void* dest = addBytesToPointer (fileBlock.getData(), i * bytesPerSample);
+
+            if (source != nullptr)
+            {
+                convertChannelToFile (file->format, dest, clientIsFloat, source, stride, numFrames);
+            }
+            else
+            {
+                // channels the client didn't supply are written as silence
+                const int silence = (bytesPerSample == 1 && (file->format.mFormatFlags & kAudioFormatFlagIsSignedInteger) == 0) ? 0x80 : 0;
+                const int fileBytesPerFrame = (int) file->format.mBytesPerFrame;
+
+                for (int j = 0; j < numFrames; ++j)
+                    memset (addBytesToPointer (dest, j * fileBytesPerFrame), silence, (size_t) bytesPerSample);
+            }
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (OpaqueExtAudioFile);
+};
+
+//==============================================================================
+OSStatus AudioFileOpenWithCallbacks (void* inClientData,
+                                     AudioFile_ReadProc inReadFunc,
+                                     AudioFile_WriteProc inWriteFunc,
+                                     AudioFile_GetSizeProc inGetSizeFunc,
+                                     AudioFile_SetSizeProc inSetSizeFunc,
+                                     AudioFileTypeID inFileTypeHint,
+                                     AudioFileID* outAudioFile)
+{
+    jassert (outAudioFile != nullptr);
+
+    ScopedPointer<OpaqueAudioFileID> file (new OpaqueAudioFileID (inClientData, inReadFunc, inWriteFunc,
+                                                                  inGetSizeFunc, inSetSizeFunc, inFileTypeHint));
+    const OSStatus status = file->open();
+
+    if (status == noErr)
+        *outAudioFile = file.release();
+
+    return status;
+}
+
+OSStatus AudioFileInitializeWithCallbacks (void* inClientData,
+                                           AudioFile_ReadProc inReadFunc,
+                                           AudioFile_WriteProc inWriteFunc,
+                                           AudioFile_GetSizeProc inGetSizeFunc,
+                                           AudioFile_SetSizeProc inSetSizeFunc,
+                                           AudioFileTypeID inFileType,
+                                           const AudioStreamBasicDescription* inFormat,
+                                           UInt32 /*inFlags*/,
+                                           AudioFileID* outAudioFile)
+{
+    jassert (inFormat != nullptr && outAudioFile != nullptr);
+
+    ScopedPointer<OpaqueAudioFileID> file (new OpaqueAudioFileID (inClientData, inReadFunc, inWriteFunc,
+                                                                  inGetSizeFunc, inSetSizeFunc, inFileType));
+    const OSStatus status = file->initialise (*inFormat);
+
+    if (status == noErr)
+        *outAudioFile = file.release();
+
+    return status;
+}
+
+OSStatus AudioFileClose (AudioFileID inAudioFile)
+{
+    if (inAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    const OSStatus status = inAudioFile->close();
+    delete inAudioFile;
+    return status;
+}
+
+OSStatus AudioFileGetProperty (AudioFileID inAudioFile, AudioFilePropertyID inPropertyID,
+                               UInt32* ioDataSize, void* outPropertyData)
+{
+    if (inAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    switch (inPropertyID)
+    {
+        case kAudioFilePropertyDataFormat:
+            if (*ioDataSize < sizeof (AudioStreamBasicDescription))
+                return kAudioFileBadPropertySizeError;
+
+            *static_cast<AudioStreamBasicDescription*> (outPropertyData) = inAudioFile->format;
+            *ioDataSize = sizeof (AudioStreamBasicDescription);
+            return noErr;
+
+        case kAudioFilePropertyDataOffset:
+            if (*ioDataSize < sizeof (SInt64))
+                return kAudioFileBadPropertySizeError;
+
+            *static_cast<SInt64*> (outPropertyData) = inAudioFile->dataOffset;
+            *ioDataSize = sizeof (SInt64);
+            return noErr;
+
+        case kAudioFilePropertyAudioDataByteCount:
+            if (*ioDataSize < sizeof (UInt64))
+                return kAudioFileBadPropertySizeError;
+
+            *static_cast<UInt64*> (outPropertyData) = (UInt64) inAudioFile->dataSize;
+            *ioDataSize = sizeof (UInt64);
+            return noErr;
+
+        default:
+            break;
+    }
+
+    return kAudioFileUnsupportedPropertyError;
+}
+
+OSStatus AudioFileGetGlobalInfoSize (AudioFilePropertyID inPropertyID, UInt32, void*, UInt32* outDataSize)
+{
+    if (inPropertyID != kAudioFileGlobalInfo_ReadableTypes
+         && inPropertyID != kAudioFileGlobalInfo_WritableTypes)
+        return kAudioFileUnsupportedPropertyError;
+
+    *outDataSize = sizeof (supportedFileTypes);
+    return noErr;
+}
+
+OSStatus AudioFileGetGlobalInfo (AudioFilePropertyID inPropertyID, UInt32 inSpecifierSize, void* inSpecifier,
+                                 UInt32* ioDataSize, void* outPropertyData)
+{
+    UInt32 size = 0;
+    const OSStatus status = AudioFileGetGlobalInfoSize (inPropertyID, inSpecifierSize, inSpecifier, &size);
+
+    if (status != noErr)
+        return status;
+
+    if (*ioDataSize < size)
+        return kAudioFileBadPropertySizeError;
+
+    memcpy (outPropertyData, supportedFileTypes, size);
+    *ioDataSize = size;
+    return noErr;
+}
+
+//==============================================================================
+OSStatus ExtAudioFileWrapAudioFileID (AudioFileID inFileID, Boolean, ExtAudioFileRef* outExtAudioFile)
+{
+    if (inFileID == nullptr)
+        return kAudioFileNotOpenError;
+
+    *outExtAudioFile = new OpaqueExtAudioFile (inFileID);
+    return noErr;
+}
+
+OSStatus ExtAudioFileDispose (ExtAudioFileRef inExtAudioFile)
+{
+    // as with the real thing, the wrapped AudioFileID still needs closing by the caller
+    delete inExtAudioFile;
+    return noErr;
+}
+
+OSStatus ExtAudioFileGetProperty (ExtAudioFileRef inExtAudioFile, ExtAudioFilePropertyID inPropertyID,
+                                  UInt32* ioPropertyDataSize, void* outPropertyData)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    switch (inPropertyID)
+    {
+        case kExtAudioFileProperty_FileDataFormat:
+        case kExtAudioFileProperty_ClientDataFormat:
+            if (*ioPropertyDataSize < sizeof (AudioStreamBasicDescription))
+                return kExtAudioFileError_InvalidPropertySize;
+
+            *static_cast<AudioStreamBasicDescription*> (outPropertyData)
+                = inPropertyID == kExtAudioFileProperty_FileDataFormat ? inExtAudioFile->file->format
+                                                                       : inExtAudioFile->clientFormat;
+            *ioPropertyDataSize = sizeof (AudioStreamBasicDescription);
+            return noErr;
+
+        case kExtAudioFileProperty_FileLengthFrames:
+            if (*ioPropertyDataSize < sizeof (SInt64))
+                return kExtAudioFileError_InvalidPropertySize;
+
+            *static_cast<SInt64*> (outPropertyData) = inExtAudioFile->file->getLengthInFrames();
+            *ioPropertyDataSize = sizeof (SInt64);
+            return noErr;
+
+        default:
+            break;
+    }
+
+    return kExtAudioFileError_InvalidProperty;
+}
+
+OSStatus ExtAudioFileSetProperty (ExtAudioFileRef inExtAudioFile, ExtAudioFilePropertyID inPropertyID,
+                                  UInt32 inPropertyDataSize, const void* inPropertyData)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    if (inPropertyID != kExtAudioFileProperty_ClientDataFormat)
+        return kExtAudioFileError_InvalidProperty;
+
+    if (inPropertyDataSize < sizeof (AudioStreamBasicDescription))
+        return kExtAudioFileError_InvalidPropertySize;
+
+    return inExtAudioFile->setClientFormat (*static_cast<const AudioStreamBasicDescription*> (inPropertyData));
+}
+
+OSStatus ExtAudioFileRead (ExtAudioFileRef inExtAudioFile, UInt32* ioNumberFrames, AudioBufferList* ioData)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    return inExtAudioFile->read (*ioNumberFrames, *ioData);
+}
+
+OSStatus ExtAudioFileWrite (ExtAudioFileRef inExtAudioFile, UInt32 inNumberFrames, const AudioBufferList* ioData)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    return inExtAudioFile->write (inNumberFrames, *ioData);
+}
+
+OSStatus ExtAudioFileSeek (ExtAudioFileRef inExtAudioFile, SInt64 inFrameOffset)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    if (inFrameOffset < 0 || inFrameOffset > inExtAudioFile->file->getLengthInFrames())
+        return kExtAudioFileError_InvalidSeek;
+
+    inExtAudioFile->framePosition = inFrameOffset;
+    return noErr;
+}
+
+OSStatus ExtAudioFileTell (ExtAudioFileRef inExtAudioFile, SInt64* outFrameOffset)
+{
+    if (inExtAudioFile == nullptr)
+        return kAudioFileNotOpenError;
+
+    *outFrameOffset = inExtAudioFile->framePosition;
+    return noErr;
+}
+
+//==============================================================================
+StringArray PortableAudioToolbox::getAllExtensions()
+{
+    const char* const extensions[] = { ".caf", ".wav", ".wave", ".bwf", nullptr };
+    return StringArray (extensions);
+}
+
+#endif
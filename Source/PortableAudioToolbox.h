@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    PortableAudioToolbox.h
+    Created: 16 Oct 2026 10:12:41am
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __PORTABLEAUDIOTOOLBOX_H_6E0A31D9__
+#define __PORTABLEAUDIOTOOLBOX_H_6E0A31D9__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if ! (JUCE_MAC || JUCE_IOS)
+
+//==============================================================================
+/*
+    A portable stand-in for the small part of the AudioToolbox AudioFile and
+    ExtAudioFile APIs that CoreAudioFormatNew relies on.
+
+    This lets CoreAudioReader and CoreAudioWriter run unchanged on platforms
+    without AudioToolbox: files are opened and initialised through the same
+    client callbacks, and the ExtAudioFile layer converts between the file's
+    linear PCM data and the client format.
+
+    Only uncompressed CAF and WAV files are understood, and no sample rate
+    conversion is done.
+*/
+
+typedef int32   OSStatus;
+typedef uint32  UInt32;
+typedef int32   SInt32;
+typedef int64   SInt64;
+typedef uint64  UInt64;
+typedef double  Float64;
+typedef bool    Boolean;
+
+typedef UInt32  AudioFileTypeID;
+typedef UInt32  AudioFormatID;
+typedef UInt32  AudioFormatFlags;
+typedef UInt32  AudioFilePropertyID;
+typedef UInt32  ExtAudioFilePropertyID;
+
+typedef struct OpaqueAudioFileID*   AudioFileID;
+typedef struct OpaqueExtAudioFile*  ExtAudioFileRef;
+
+//==============================================================================
+struct AudioStreamBasicDescription
+{
+    Float64             mSampleRate;
+    AudioFormatID       mFormatID;
+    AudioFormatFlags    mFormatFlags;
+    UInt32              mBytesPerPacket;
+    UInt32              mFramesPerPacket;
+    UInt32              mBytesPerFrame;
+    UInt32              mChannelsPerFrame;
+    UInt32              mBitsPerChannel;
+    UInt32              mReserved;
+};
+
+struct AudioBuffer
+{
+    UInt32  mNumberChannels;
+    UInt32  mDataByteSize;
+    void*   mData;
+};
+
+struct AudioBufferList
+{
+    UInt32      mNumberBuffers;
+    AudioBuffer mBuffers[1];
+};
+
+//==============================================================================
+typedef OSStatus (*AudioFile_ReadProc)    (void* inClientData, SInt64 inPosition, UInt32 requestCount, void* buffer, UInt32* actualCount);
+typedef OSStatus (*AudioFile_WriteProc)   (void* inClientData, SInt64 inPosition, UInt32 requestCount, const void* buffer, UInt32* actualCount);
+typedef SInt64   (*AudioFile_GetSizeProc) (void* inClientData);
+typedef OSStatus (*AudioFile_SetSizeProc) (void* inClientData, SInt64 inSize);
+
+//==============================================================================
+enum
+{
+    noErr                                   = 0,
+
+    kAudioFileUnspecifiedError              = 0x7768743f,   // 'wht?'
+    kAudioFileUnsupportedFileTypeError      = 0x7479703f,   // 'typ?'
+    kAudioFileUnsupportedDataFormatError    = 0x666d743f,   // 'fmt?'
+    kAudioFileUnsupportedPropertyError      = 0x7074793f,   // 'pty?'
+    kAudioFileBadPropertySizeError          = 0x2173697a,   // '!siz'
+    kAudioFilePermissionsError              = 0x70726d3f,   // 'prm?'
+    kAudioFileInvalidFileError              = 0x6474613f,   // 'dta?'
+    kAudioFileNotOpenError                  = -38,
+    kAudioFileEndOfFileError                = -39,
+    kAudioFilePositionError                 = -40,
+
+    kExtAudioFileError_InvalidProperty          = -66561,
+    kExtAudioFileError_InvalidPropertySize      = -66562,
+    kExtAudioFileError_NonPCMClientFormat       = -66563,
+    kExtAudioFileError_InvalidChannelMap        = -66564,
+    kExtAudioFileError_InvalidOperationOrder    = -66565,
+    kExtAudioFileError_InvalidDataFormat        = -66566,
+    kExtAudioFileError_InvalidSeek              = -66568
+};
+
+enum
+{
+    kAudioFormatLinearPCM                   = 0x6c70636d    // 'lpcm'
+};
+
+enum
+{
+    kAudioFormatFlagIsFloat                 = (1 << 0),
+    kAudioFormatFlagIsBigEndian             = (1 << 1),
+    kAudioFormatFlagIsSignedInteger         = (1 << 2),
+    kAudioFormatFlagIsPacked                = (1 << 3),
+    kAudioFormatFlagIsAlignedHigh           = (1 << 4),
+    kAudioFormatFlagIsNonInterleaved        = (1 << 5),
+
+    kLinearPCMFormatFlagIsFloat             = kAudioFormatFlagIsFloat,
+    kLinearPCMFormatFlagIsBigEndian         = kAudioFormatFlagIsBigEndian,
+    kLinearPCMFormatFlagIsSignedInteger     = kAudioFormatFlagIsSignedInteger,
+    kLinearPCMFormatFlagIsPacked            = kAudioFormatFlagIsPacked,
+    kLinearPCMFormatFlagIsAlignedHigh       = kAudioFormatFlagIsAlignedHigh,
+    kLinearPCMFormatFlagIsNonInterleaved    = kAudioFormatFlagIsNonInterleaved,
+
+   #if JUCE_BIG_ENDIAN
+    kAudioFormatFlagsNativeEndian           = kAudioFormatFlagIsBigEndian
+   #else
+    kAudioFormatFlagsNativeEndian           = 0
+   #endif
+};
+
+enum
+{
+    kAudioFileWAVEType                      = 0x57415645,   // 'WAVE'
+    kAudioFileCAFType                       = 0x63616666    // 'caff'
+};
+
+enum
+{
+    kAudioFileGlobalInfo_ReadableTypes      = 0x61667266,   // 'afrf'
+    kAudioFileGlobalInfo_WritableTypes      = 0x61667766    // 'afwf'
+};
+
+enum
+{
+    kAudioFilePropertyDataFormat            = 0x64666d74,   // 'dfmt'
+    kAudioFilePropertyDataOffset            = 0x646f6666,   // 'doff'
+    kAudioFilePropertyAudioDataByteCount    = 0x62636e74    // 'bcnt'
+};
+
+enum
+{
+    kExtAudioFileProperty_FileDataFormat    = 0x66666d74,   // 'ffmt'
+    kExtAudioFileProperty_ClientDataFormat  = 0x63666d74,   // 'cfmt'
+    kExtAudioFileProperty_FileLengthFrames  = 0x2366726d    // '#frm'
+};
+
+//==============================================================================
+OSStatus AudioFileOpenWithCallbacks (void* inClientData,
+                                     AudioFile_ReadProc inReadFunc,
+                                     AudioFile_WriteProc inWriteFunc,
+                                     AudioFile_GetSizeProc inGetSizeFunc,
+                                     AudioFile_SetSizeProc inSetSizeFunc,
+                                     AudioFileTypeID inFileTypeHint,
+                                     AudioFileID* outAudioFile);
+
+OSStatus AudioFileInitializeWithCallbacks (void* inClientData,
+                                           AudioFile_ReadProc inReadFunc,
+                                           AudioFile_WriteProc inWriteFunc,
+                                           AudioFile_GetSizeProc inGetSizeFunc,
+                                           AudioFile_SetSizeProc inSetSizeFunc,
+                                           AudioFileTypeID inFileType,
+                                           const AudioStreamBasicDescription* inFormat,
+                                           UInt32 inFlags,
+                                           AudioFileID* outAudioFile);
+
+OSStatus AudioFileClose (AudioFileID inAudioFile);
+
+OSStatus AudioFileGetProperty (AudioFileID inAudioFile, AudioFilePropertyID inPropertyID,
+                               UInt32* ioDataSize, void* outPropertyData);
+
+OSStatus AudioFileGetGlobalInfoSize (AudioFilePropertyID inPropertyID,
+                                     UInt32 inSpecifierSize, void* inSpecifier,
+                                     UInt32* outDataSize);
+
+OSStatus AudioFileGetGlobalInfo (AudioFilePropertyID inPropertyID,
+                                 UInt32 inSpecifierSize, void* inSpecifier,
+                                 UInt32* ioDataSize, void* outPropertyData);
+
+//==============================================================================
+OSStatus ExtAudioFileWrapAudioFileID (AudioFileID inFileID, Boolean inForWriting, ExtAudioFileRef* outExtAudioFile);
+OSStatus ExtAudioFileDispose (ExtAudioFileRef inExtAudioFile);
+
+OSStatus ExtAudioFileGetProperty (ExtAudioFileRef inExtAudioFile, ExtAudioFilePropertyID inPropertyID,
+                                  UInt32* ioPropertyDataSize, void* outPropertyData);
+OSStatus ExtAudioFileSetProperty (ExtAudioFileRef inExtAudioFile, ExtAudioFilePropertyID inPropertyID,
+                                  UInt32 inPropertyDataSize, const void* inPropertyData);
+
+OSStatus ExtAudioFileRead  (ExtAudioFileRef inExtAudioFile, UInt32* ioNumberFrames, AudioBufferList* ioData);
+OSStatus ExtAudioFileWrite (ExtAudioFileRef inExtAudioFile, UInt32 inNumberFrames, const AudioBufferList* ioData);
+OSStatus ExtAudioFileSeek  (ExtAudioFileRef inExtAudioFile, SInt64 inFrameOffset);
+OSStatus ExtAudioFileTell  (ExtAudioFileRef inExtAudioFile, SInt64* outFrameOffset);
+
+//==============================================================================
+namespace PortableAudioToolbox
+{
+    /** Returns the file extensions that the portable backend can open, e.g. ".caf". */
+    StringArray getAllExtensions();
+}
+
+#endif
+
+#endif  // __PORTABLEAUDIOTOOLBOX_H_6E0A31D9__
@@ -0,0 +1,1189 @@
+/*
+  ==============================================================================
+
+    PositionalOutput.cpp
+    Created: 17 Oct 2026 9:04:18am
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "PositionalOutput.h"
+#include "ConcurrencyHelpers.h"
+
+#if ! JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <errno.h>
+ #include <sys/mman.h>
+#endif
+
+#if JUCE_LINUX && defined (__has_include)
+ #if __has_include (<linux/io_uring.h>)
+  #include <linux/io_uring.h>
+  #include <sys/syscall.h>
+  #include <sys/uio.h>
+
+  #if defined (__NR_io_uring_setup) && defined (__NR_io_uring_enter)
+   #define JUCE_POSITIONAL_OUTPUT_USE_IO_URING 1
+  #endif
+ #endif
+#endif
+
+//==============================================================================
+FileOutputStream* PositionalOutput::getFlushedFileStream (OutputStream& stream)
+{
+   #if JUCE_WINDOWS
+    // FileOutputStream doesn't share write access on Windows, so we can't open a second handle
+    (void) stream;
+    return nullptr;
+   #else
+    FileOutputStream* const fileStream = dynamic_cast<FileOutputStream*> (&stream);
+
+    // anything the stream has buffered must be in the file before we start writing around it
+    if (fileStream != nullptr)
+        fileStream->flush();
+
+    return fileStream;
+   #endif
+}
+
+PositionalOutput* PositionalOutput::createFor (OutputStream& stream)
+{
+    FileOutputStream* const fileStream = getFlushedFileStream (stream);
+
+    if (fileStream != nullptr)
+    {
+        ScopedPointer<FilePositionalOutput> fileOutput (new FilePositionalOutput (fileStream->getFile(),
+                                                                                  fileStream->getPosition()));
+        if (fileOutput->openedOk())
+            return fileOutput.release();
+    }
+
+    return new StreamPositionalOutput (stream);
+}
+
+PositionalOutput* PositionalOutput::createMemoryMappedFor (OutputStream& stream)
+{
+    FileOutputStream* const fileStream = getFlushedFileStream (stream);
+
+    if (fileStream != nullptr)
+    {
+        ScopedPointer<MappedPositionalOutput> mappedOutput (new MappedPositionalOutput (fileStream->getFile(),
+                                                                                        fileStream->getPosition()));
+        if (mappedOutput->openedOk())
+            return mappedOutput.release();
+    }
+
+    return nullptr;
+}
+
+PositionalOutput* PositionalOutput::createDirectFor (OutputStream& stream)
+{
+    FileOutputStream* const fileStream = getFlushedFileStream (stream);
+
+    if (fileStream != nullptr)
+    {
+        ScopedPointer<DirectPositionalOutput> directOutput (new DirectPositionalOutput (fileStream->getFile(),
+                                                                                        fileStream->getPosition()));
+        if (directOutput->openedOk())
+            return directOutput.release();
+    }
+
+    return nullptr;
+}
+
+PositionalOutput* PositionalOutput::createAsynchronousFor (OutputStream& stream)
+{
+    FileOutputStream* const fileStream = getFlushedFileStream (stream);
+
+    if (fileStream != nullptr)
+    {
+        ScopedPointer<AsyncPositionalOutput> asyncOutput (new AsyncPositionalOutput (fileStream->getFile(),
+                                                                                     fileStream->getPosition()));
+        if (asyncOutput->openedOk())
+            return asyncOutput.release();
+    }
+
+    return nullptr;
+}
+
+//==============================================================================
+StreamPositionalOutput::StreamPositionalOutput (OutputStream& stream_)
+    : PositionalOutput (stream_.getPosition()),
+      stream (stream_)
+{
+}
+
+bool StreamPositionalOutput::seekTo (int64 position)
+{
+    // appending is by far the most common case, and needs no seek
+    return stream.getPosition() == position || stream.setPosition (position);
+}
+
+bool StreamPositionalOutput::writeAt (int64 position, const void* data, size_t numBytes)
+{
+    if (! (seekTo (position) && stream.write (data, numBytes)))
+        return false;
+
+    size = jmax (size, position + (int64) numBytes);
+    return true;
+}
+
+int StreamPositionalOutput::readAt (int64 position, void* dest, int numBytes)
+{
+    // anything being read back has to have reached the destination first
+    stream.flush();
+
+    MemoryOutputStream* const memoryOutput = dynamic_cast<MemoryOutputStream*> (&stream);
+
+    if (memoryOutput != nullptr)
+    {
+        // the block may have been reallocated since the last read, so this can't be kept
+        MemoryInputStream memoryInput (memoryOutput->getData(), memoryOutput->getDataSize(), false);
+        memoryInput.setPosition (position);
+        return memoryInput.read (dest, numBytes);
+    }
+
+    if (input == nullptr)
+    {
+        FileOutputStream* const fileOutput = dynamic_cast<FileOutputStream*> (&stream);
+
+        if (fileOutput != nullptr)
+            input = new FileInputStream (fileOutput->getFile());
+    }
+
+    if (input == nullptr || ! input->setPosition (position))
+        return 0;
+
+    return input->read (dest, numBytes);
+}
+
+bool StreamPositionalOutput::growTo (int64 newSize)
+{
+    if (newSize <= size)
+        return true;
+
+    if (! seekTo (size))
+        return false;
+
+    stream.writeRepeatedByte (0, (size_t) (newSize - size));
+    size = newSize;
+    return true;
+}
+
+bool StreamPositionalOutput::flush()
+{
+    stream.flush();
+    return true;
+}
+
+//==============================================================================
+#if JUCE_WINDOWS
+
+FilePositionalOutput::FilePositionalOutput (const File&, int64 initialSize)
+    : PositionalOutput (initialSize), fileHandle (-1), hasReservedSpace (false)
+{
+}
+
+FilePositionalOutput::~FilePositionalOutput() {}
+
+bool FilePositionalOutput::writeAt (int64, const void*, size_t)     { return false; }
+int FilePositionalOutput::readAt (int64, void*, int)                { return 0; }
+bool FilePositionalOutput::growTo (int64)                           { return false; }
+bool FilePositionalOutput::reserve (int64)                          { return false; }
+bool FilePositionalOutput::flush()                                  { return false; }
+bool FilePositionalOutput::allocate (int64, int64, bool)            { return false; }
+
+MappedPositionalOutput::MappedPositionalOutput (const File& file, int64 initialSize)
+    : FilePositionalOutput (file, initialSize), mappedData (nullptr), mappedSize (0)
+{
+}
+
+MappedPositionalOutput::~MappedPositionalOutput() {}
+
+bool MappedPositionalOutput::writeAt (int64, const void*, size_t)   { return false; }
+int MappedPositionalOutput::readAt (int64, void*, int)              { return 0; }
+bool MappedPositionalOutput::growTo (int64)                         { return false; }
+bool MappedPositionalOutput::reserve (int64)                        { return false; }
+bool MappedPositionalOutput::flush()                                { return false; }
+bool MappedPositionalOutput::ensureMapped (int64)                   { return false; }
+void MappedPositionalOutput::unmap()                                {}
+
+class AsyncPositionalOutput::Engine {};
+
+AsyncPositionalOutput::AsyncPositionalOutput (const File& file, int64 initialSize, int)
+    : FilePositionalOutput (file, initialSize)
+{
+}
+
+AsyncPositionalOutput::~AsyncPositionalOutput() {}
+
+bool AsyncPositionalOutput::writeAt (int64, const void*, size_t)    { return false; }
+int AsyncPositionalOutput::readAt (int64, void*, int)               { return 0; }
+bool AsyncPositionalOutput::flush()                                 { return false; }
+bool AsyncPositionalOutput::waitForPendingWrites()                  { return false; }
+
+DirectPositionalOutput::DirectPositionalOutput (const File& file, int64 initialSize, int)
+    : FilePositionalOutput (file, initialSize), directHandle (-1), blockSize (0), block (nullptr), blockStart (0),
+      numInBlock (0), bypassingCache (false)
+{
+}
+
+DirectPositionalOutput::~DirectPositionalOutput() {}
+
+bool DirectPositionalOutput::writeAt (int64, const void*, size_t)   { return false; }
+int DirectPositionalOutput::readAt (int64, void*, int)              { return 0; }
+bool DirectPositionalOutput::growTo (int64)                         { return false; }
+bool DirectPositionalOutput::flush()                                { return false; }
+bool DirectPositionalOutput::appendZeros (int64)                    { return false; }
+bool DirectPositionalOutput::writeBlock()                           { return false; }
+bool DirectPositionalOutput::moveToNextBlock()                      { return false; }
+
+#else
+
+namespace
+{
+    bool writeToHandle (int fileHandle, int64 position, const void* data, size_t numBytes)
+    {
+        const char* source = static_cast<const char*> (data);
+
+        while (numBytes > 0)
+        {
+            const ssize_t numWritten = pwrite (fileHandle, source, numBytes, (off_t) position);
+
+            if (numWritten < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return false;
+            }
+
+            source += numWritten;
+            position += numWritten;
+            numBytes -= (size_t) numWritten;
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+FilePositionalOutput::FilePositionalOutput (const File& file, int64 initialSize)
+    : PositionalOutput (initialSize),
+      fileHandle (open (file.getFullPathName().toUTF8(), O_RDWR)),
+      hasReservedSpace (false)
+{
+}
+
+FilePositionalOutput::~FilePositionalOutput()
+{
+    if (fileHandle >= 0)
+    {
+        // give back any reserved space that didn't get used
+        if (hasReservedSpace)
+            ftruncate (fileHandle, (off_t) size);
+
+        close (fileHandle);
+    }
+}
+
+bool FilePositionalOutput::writeAt (int64 position, const void* data, size_t numBytes)
+{
+    if (! writeToHandle (fileHandle, position, data, numBytes))
+        return false;
+
+    size = jmax (size, position + (int64) numBytes);
+    return true;
+}
+
+int FilePositionalOutput::readAt (int64 position, void* dest, int numBytes)
+{
+    int numRead = 0;
+
+    while (numRead < numBytes)
+    {
+        const ssize_t result = pread (fileHandle, addBytesToPointer (dest, numRead),
+                                      (size_t) (numBytes - numRead), (off_t) (position + numRead));
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result <= 0)
+            break;
+
+        numRead += (int) result;
+    }
+
+    return numRead;
+}
+
+bool FilePositionalOutput::growTo (int64 newSize)
+{
+    if (newSize <= size)
+        return true;
+
+    if (growthMode == allocateSpace)
+    {
+        // if the blocks can't be allocated up-front, a sparse extension still avoids writing anything
+        if (allocate (size, newSize - size, false) || ftruncate (fileHandle, (off_t) newSize) == 0)
+        {
+            size = newSize;
+            return true;
+        }
+    }
+
+    const size_t zeroBlockSize = 16384;
+    HeapBlock<char> zeros (zeroBlockSize, true);
+
+    while (size < newSize)
+        if (! writeAt (size, zeros, (size_t) jmin ((int64) zeroBlockSize, newSize - size)))
+            return false;
+
+    return true;
+}
+
+bool FilePositionalOutput::reserve (int64 totalSize)
+{
+    if (totalSize <= size || ! allocate (size, totalSize - size, true))
+        return false;
+
+    hasReservedSpace = true;
+    return true;
+}
+
+bool FilePositionalOutput::flush()
+{
+    return fsync (fileHandle) == 0;
+}
+
+bool FilePositionalOutput::allocate (int64 start, int64 numBytes, bool keepSize)
+{
+   #if JUCE_LINUX || JUCE_ANDROID
+    return fallocate (fileHandle, keepSize ? FALLOC_FL_KEEP_SIZE : 0, (off_t) start, (off_t) numBytes) == 0;
+   #elif JUCE_MAC || JUCE_IOS
+    // F_PREALLOCATE works from the physical end of the file, and never changes its size
+    fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t) numBytes, 0 };
+
+    if (fcntl (fileHandle, F_PREALLOCATE, &store) == -1)
+    {
+        store.fst_flags = F_ALLOCATEALL;
+
+        if (fcntl (fileHandle, F_PREALLOCATE, &store) == -1)
+            return false;
+    }
+
+    return keepSize || ftruncate (fileHandle, (off_t) (start + numBytes)) == 0;
+   #else
+    (void) start; (void) numBytes; (void) keepSize;
+    return false;
+   #endif
+}
+
+//==============================================================================
+MappedPositionalOutput::MappedPositionalOutput (const File& file, int64 initialSize)
+    : FilePositionalOutput (file, initialSize),
+      mappedData (nullptr),
+      mappedSize (0)
+{
+}
+
+MappedPositionalOutput::~MappedPositionalOutput()
+{
+    unmap();
+
+    // the file was extended in big steps, so cut it back to what was actually written
+    if (fileHandle >= 0)
+        ftruncate (fileHandle, (off_t) size);
+
+    hasReservedSpace = false;
+}
+
+bool MappedPositionalOutput::writeAt (int64 position, const void* data, size_t numBytes)
+{
+    const int64 endPosition = position + (int64) numBytes;
+
+    if (! ensureMapped (endPosition))
+        return false;
+
+    memcpy (addBytesToPointer (mappedData, position), data, numBytes);
+    size = jmax (size, endPosition);
+    return true;
+}
+
+int MappedPositionalOutput::readAt (int64 position, void* dest, int numBytes)
+{
+    numBytes = (int) jmin ((int64) numBytes, size - position);
+
+    if (numBytes <= 0 || mappedData == nullptr)
+        return 0;
+
+    memcpy (dest, addBytesToPointer (mappedData, position), (size_t) numBytes);
+    return numBytes;
+}
+
+bool MappedPositionalOutput::growTo (int64 newSize)
+{
+    if (newSize <= size)
+        return true;
+
+    if (! ensureMapped (newSize))
+        return false;
+
+    // nothing has ever been written past the old end, so it already reads as zeros
+    size = newSize;
+    return true;
+}
+
+bool MappedPositionalOutput::reserve (int64 totalSize)
+{
+    return ensureMapped (totalSize);
+}
+
+bool MappedPositionalOutput::flush()
+{
+    return mappedData == nullptr || msync (mappedData, (size_t) mappedSize, MS_SYNC) == 0;
+}
+
+bool MappedPositionalOutput::ensureMapped (int64 requiredSize)
+{
+    if (requiredSize <= mappedSize)
+        return true;
+
+    // grow in big steps so that a long recording only gets re-mapped a handful of times
+    const int64 minimumStep = 4 * 1024 * 1024;
+    const int64 maximumStep = 256 * 1024 * 1024;
+    const int64 newMappedSize = requiredSize + jlimit (minimumStep, maximumStep, mappedSize);
+
+    // allocating the blocks now means running out of disk space is an error here, rather than a SIGBUS later
+    if (growthMode == allocateSpace)
+    {
+        if (! allocate (mappedSize, newMappedSize - mappedSize, false))
+            return false;
+    }
+    else if (ftruncate (fileHandle, (off_t) newMappedSize) != 0)
+    {
+        return false;
+    }
+
+    unmap();
+
+    void* const newData = mmap (nullptr, (size_t) newMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileHandle, 0);
+
+    if (newData == MAP_FAILED)
+        return false;
+
+    mappedData = newData;
+    mappedSize = newMappedSize;
+    return true;
+}
+
+void MappedPositionalOutput::unmap()
+{
+    if (mappedData != nullptr)
+    {
+        munmap (mappedData, (size_t) mappedSize);
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+}
+
+//==============================================================================
+class AsyncPositionalOutput::Engine
+{
+public:
+    Engine (int fileHandle_, int maxBytesInFlight_)
+        : fileHandle (fileHandle_), maxBytesInFlight (maxBytesInFlight_), failed (0)
+    {
+    }
+
+    virtual ~Engine() {}
+
+    /** Queues a copy of the data to be written. */
+    virtual bool write (int64 position, const void* data, size_t numBytes) = 0;
+
+    /** Queues an fsync that won't start until everything before it has been written. */
+    virtual bool sync() = 0;
+
+    virtual bool waitForAll() = 0;
+
+    /** Returns true if any queued write touches the given range of the file. */
+    virtual bool isPending (int64 start, int64 end) = 0;
+
+    bool hasFailed() const noexcept     { return failed.get() != 0; }
+
+protected:
+    struct Request
+    {
+        Request() noexcept : position (0), numBytes (0), isSync (false), inUse (false) {}
+
+        bool overlaps (int64 start, int64 end) const noexcept
+        {
+            return inUse && ! isSync && start < position + (int64) numBytes && position < end;
+        }
+
+        int64 position;
+        MemoryBlock data;
+        size_t numBytes;
+        bool isSync, inUse;
+    };
+
+    const int fileHandle, maxBytesInFlight;
+    Atomic<int> failed;
+
+    bool perform (Request& request)
+    {
+        if (request.isSync)
+            return fsync (fileHandle) == 0;
+
+        return writeToHandle (fileHandle, request.position, request.data.getData(), request.numBytes);
+    }
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (Engine);
+};
+
+//==============================================================================
+namespace
+{
+    ThreadPool* createWritebackPool()   { return new ThreadPool (4); }
+
+    LazySingleton<ThreadPool> sharedWritebackPool (createWritebackPool);
+
+    ThreadPool& getSharedWritebackPool()
+    {
+        return sharedWritebackPool.get();
+    }
+
+    /** Does the writes for one file in order, on the shared writeback pool. */
+    class PoolEngine  : public AsyncPositionalOutput::Engine,
+                        private ThreadPoolJob
+    {
+    public:
+        PoolEngine (int fileHandle_, int maxBytesInFlight_)
+            : Engine (fileHandle_, maxBytesInFlight_),
+              ThreadPoolJob ("Async file writer"),
+              bytesQueued (0),
+              isQueuedOnPool (false)
+        {
+        }
+
+        ~PoolEngine()
+        {
+            waitForAll();
+            getSharedWritebackPool().waitForJobToFinish (this, -1);
+        }
+
+        bool write (int64 position, const void* data, size_t numBytes)
+        {
+            // don't let a stalled disk soak up unlimited memory
+            for (;;)
+            {
+                {
+                    const ScopedLock sl (lock);
+
+                    if (bytesQueued == 0 || bytesQueued + (int64) numBytes <= maxBytesInFlight || hasFailed())
+                        break;
+                }
+
+                requestFinished.wait (100);
+            }
+
+            Request* const request = new Request();
+            request->position = position;
+            request->data.append (data, numBytes);
+            request->numBytes = numBytes;
+
+            return enqueue (request);
+        }
+
+        bool sync()
+        {
+            Request* const request = new Request();
+            request->isSync = true;
+
+            return enqueue (request);
+        }
+
+        bool waitForAll()
+        {
+            for (;;)
+            {
+                {
+                    const ScopedLock sl (lock);
+
+                    if (! isQueuedOnPool)
+                        break;
+                }
+
+                requestFinished.wait (100);
+            }
+
+            return ! hasFailed();
+        }
+
+        bool isPending (int64 start, int64 end)
+        {
+            const ScopedLock sl (lock);
+
+            for (int i = queue.size(); --i >= 0;)
+                if (queue.getUnchecked (i)->overlaps (start, end))
+                    return true;
+
+            return false;
+        }
+
+    private:
+        CriticalSection lock;
+        OwnedArray<Request> queue;      // the first one is the one being written
+        WaitableEvent requestFinished;
+        int64 bytesQueued;
+        bool isQueuedOnPool;
+
+        bool enqueue (Request* request)
+        {
+            const ScopedLock sl (lock);
+
+            request->inUse = true;
+            queue.add (request);
+            bytesQueued += (int64) request->numBytes;
+
+            requeueDrainingJob (getSharedWritebackPool(), this, isQueuedOnPool);
+
+            return ! hasFailed();
+        }
+
+        JobStatus runJob()
+        {
+            for (;;)
+            {
+                Request* request;
+
+                {
+                    const ScopedLock sl (lock);
+
+                    if (queue.size() == 0)
+                    {
+                        isQueuedOnPool = false;
+                        requestFinished.signal();
+                        return jobHasFinished;
+                    }
+
+                    request = queue.getUnchecked (0);
+                }
+
+                if (! perform (*request))
+                    failed = 1;
+
+                const ScopedLock sl (lock);
+                bytesQueued -= (int64) request->numBytes;
+                queue.remove (0);
+                requestFinished.signal();
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PoolEngine);
+    };
+
+   #if JUCE_POSITIONAL_OUTPUT_USE_IO_URING
+    /** Submits writes with io_uring, keeping up to maxRequestsInFlight of them going at once.
+
+        Everything happens on the thread that calls it: completions are collected
+        whenever a new write is submitted, and the caller only waits when all the
+        request slots are busy.
+    */
+    class UringEngine  : public AsyncPositionalOutput::Engine
+    {
+    public:
+        UringEngine (int fileHandle_, int maxBytesInFlight_)
+            : Engine (fileHandle_, maxBytesInFlight_),
+              ringHandle (-1), sqRing (MAP_FAILED), cqRing (MAP_FAILED), sqes (MAP_FAILED),
+              sqRingSize (0), cqRingSize (0), sqesSize (0),
+              numInFlight (0), bytesInFlight (0)
+        {
+            io_uring_params params;
+            zerostruct (params);
+
+            ringHandle = (int) syscall (__NR_io_uring_setup, (unsigned) maxRequestsInFlight, &params);
+
+            if (ringHandle < 0)
+                return;
+
+            sqRingSize = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+            cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+            sqesSize = params.sq_entries * sizeof (io_uring_sqe);
+
+            sqRing = mmap (nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQ_RING);
+            cqRing = mmap (nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_CQ_RING);
+            sqes   = mmap (nullptr, sqesSize,   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQES);
+
+            if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED)
+                return;
+
+            sqTail  = (unsigned*) addBytesToPointer (sqRing, params.sq_off.tail);
+            sqMask  = *(unsigned*) addBytesToPointer (sqRing, params.sq_off.ring_mask);
+            sqArray = (unsigned*) addBytesToPointer (sqRing, params.sq_off.array);
+            cqHead  = (unsigned*) addBytesToPointer (cqRing, params.cq_off.head);
+            cqTail  = (unsigned*) addBytesToPointer (cqRing, params.cq_off.tail);
+            cqMask  = *(unsigned*) addBytesToPointer (cqRing, params.cq_off.ring_mask);
+            cqes    = (io_uring_cqe*) addBytesToPointer (cqRing, params.cq_off.cqes);
+        }
+
+        ~UringEngine()
+        {
+            if (isOk())
+                waitForAll();
+
+            if (sqes != MAP_FAILED)     munmap (sqes, sqesSize);
+            if (cqRing != MAP_FAILED)   munmap (cqRing, cqRingSize);
+            if (sqRing != MAP_FAILED)   munmap (sqRing, sqRingSize);
+
+            if (ringHandle >= 0)
+                close (ringHandle);
+        }
+
+        bool isOk() const noexcept
+        {
+            return ringHandle >= 0 && sqRing != MAP_FAILED && cqRing != MAP_FAILED && sqes != MAP_FAILED;
+        }
+
+        bool write (int64 position, const void* data, size_t numBytes)
+        {
+            while (numInFlight > 0 && bytesInFlight + (int64) numBytes > maxBytesInFlight)
+                if (! reap (true))
+                    return false;
+
+            Request* const request = getFreeRequest();
+
+            if (request == nullptr)
+                return false;
+
+            request->position = position;
+            request->data.setSize (numBytes, false);
+            request->data.copyFrom (data, 0, numBytes);
+            request->numBytes = numBytes;
+            request->isSync = false;
+
+            return submit (*request);
+        }
+
+        bool sync()
+        {
+            Request* const request = getFreeRequest();
+
+            if (request == nullptr)
+                return false;
+
+            request->numBytes = 0;
+            request->isSync = true;
+
+            return submit (*request);
+        }
+
+        bool waitForAll()
+        {
+            while (numInFlight > 0)
+                if (! reap (true))
+                    break;
+
+            return ! hasFailed();
+        }
+
+        bool isPending (int64 start, int64 end)
+        {
+            reap (false);
+
+            for (int i = 0; i < maxRequestsInFlight; ++i)
+                if (requests[i].overlaps (start, end))
+                    return true;
+
+            return false;
+        }
+
+    private:
+        enum { maxRequestsInFlight = 16 };
+
+        int ringHandle;
+        void* sqRing;
+        void* cqRing;
+        void* sqes;
+        size_t sqRingSize, cqRingSize, sqesSize;
+        unsigned* sqTail;
+        unsigned* sqArray;
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned sqMask, cqMask;
+        io_uring_cqe* cqes;
+
+        Request requests [maxRequestsInFlight];
+        iovec iovecs [maxRequestsInFlight];
+        int numInFlight;
+        int64 bytesInFlight;
+
+        Request* getFreeRequest()
+        {
+            reap (false);
+
+            while (numInFlight >= maxRequestsInFlight)
+                if (! reap (true))
+                    return nullptr;
+
+            for (int i = 0; i < maxRequestsInFlight; ++i)
+                if (! requests[i].inUse)
+                    return requests + i;
+
+            jassertfalse;
+            return nullptr;
+        }
+
+        bool submit (Request& request)
+        {
+            const int index = (int) (&request - requests);
+            const unsigned tail = *sqTail;
+            const unsigned slot = tail & sqMask;
+
+            io_uring_sqe& sqe = static_cast<io_uring_sqe*> (sqes) [slot];
+            zerostruct (sqe);
+            sqe.fd = fileHandle;
+            sqe.user_data = (uint64) index;
+
+            if (request.isSync)
+            {
+                // (the drain flag stops this starting until every earlier write has finished)
+                sqe.opcode = IORING_OP_FSYNC;
+                sqe.flags = IOSQE_IO_DRAIN;
+            }
+            else
+            {
+                iovecs[index].iov_base = request.data.getData();
+                iovecs[index].iov_len = request.numBytes;
+
+                sqe.opcode = IORING_OP_WRITEV;
+                sqe.off = (uint64) request.position;
+                sqe.addr = (uint64) (pointer_sized_int) (iovecs + index);
+                sqe.len = 1;
+            }
+
+            sqArray[slot] = slot;
+            __atomic_store_n (sqTail, tail + 1, __ATOMIC_RELEASE);
+
+            request.inUse = true;
+            ++numInFlight;
+            bytesInFlight += (int64) request.numBytes;
+
+            while (syscall (__NR_io_uring_enter, ringHandle, 1, 0, 0, nullptr, 0) < 0)
+            {
+                if (errno != EINTR && errno != EAGAIN)
+                {
+                    // the kernel hasn't taken it, so do it here instead
+                    __atomic_store_n (sqTail, tail, __ATOMIC_RELEASE);
+                    complete (request, perform (request));
+                    break;
+                }
+            }
+
+            return ! hasFailed();
+        }
+
+        /** Collects any finished requests, waiting for at least one if wait is true. */
+        bool reap (bool wait)
+        {
+            bool reapedAny = false;
+
+            for (;;)
+            {
+                const unsigned head = *cqHead;
+
+                if (head == __atomic_load_n (cqTail, __ATOMIC_ACQUIRE))
+                {
+                    if (reapedAny || ! wait || numInFlight == 0)
+                        return reapedAny || ! wait;
+
+                    if (syscall (__NR_io_uring_enter, ringHandle, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                         && errno != EINTR)
+                    {
+                        failed = 1;
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                const io_uring_cqe& cqe = cqes [head & cqMask];
+                Request& request = requests [(int) cqe.user_data];
+                const int result = cqe.res;
+
+                __atomic_store_n (cqHead, head + 1, __ATOMIC_RELEASE);
+
+                bool ok = result >= 0;
+
+                // a short write to a regular file is rare, but the rest still has to go somewhere
+                if (ok && ! request.isSync && (size_t) result < request.numBytes)
+                    ok = writeToHandle (fileHandle, request.position + result,
+                                        addBytesToPointer (request.data.getData(), result),
+                                        request.numBytes - (size_t) result);
+
+                complete (request, ok);
+                reapedAny = true;
+            }
+        }
+
+        void complete (Request& request, bool ok)
+        {
+            if (! ok)
+                failed = 1;
+
+            request.inUse = false;
+            --numInFlight;
+            bytesInFlight -= (int64) request.numBytes;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UringEngine);
+    };
+   #endif
+}
+
+//==============================================================================
+AsyncPositionalOutput::AsyncPositionalOutput (const File& file, int64 initialSize, int maxBytesInFlight)
+    : FilePositionalOutput (file, initialSize)
+{
+    if (! FilePositionalOutput::openedOk())
+        return;
+
+   #if JUCE_POSITIONAL_OUTPUT_USE_IO_URING
+    ScopedPointer<UringEngine> uringEngine (new UringEngine (fileHandle, maxBytesInFlight));
+
+    if (uringEngine->isOk())
+    {
+        engine = uringEngine.release();
+        return;
+    }
+   #endif
+
+    engine = new PoolEngine (fileHandle, maxBytesInFlight);
+}
+
+AsyncPositionalOutput::~AsyncPositionalOutput()
+{
+    // this has to finish before the base class closes the file
+    engine = nullptr;
+}
+
+bool AsyncPositionalOutput::writeAt (int64 position, const void* data, size_t numBytes)
+{
+    const int64 endPosition = position + (int64) numBytes;
+
+    // the encoder does go back and rewrite its header, and that mustn't race with the earlier write
+    if (engine->isPending (position, endPosition) && ! engine->waitForAll())
+        return false;
+
+    if (! engine->write (position, data, numBytes))
+        return false;
+
+    size = jmax (size, endPosition);
+    return true;
+}
+
+int AsyncPositionalOutput::readAt (int64 position, void* dest, int numBytes)
+{
+    if (engine->isPending (position, position + numBytes))
+        engine->waitForAll();
+
+    return FilePositionalOutput::readAt (position, dest, numBytes);
+}
+
+bool AsyncPositionalOutput::flush()
+{
+    return engine->sync();
+}
+
+bool AsyncPositionalOutput::waitForPendingWrites()
+{
+    return engine->waitForAll();
+}
+
+//==============================================================================
+DirectPositionalOutput::DirectPositionalOutput (const File& file, int64 initialSize, int blockSize_)
+    : FilePositionalOutput (file, initialSize),
+      directHandle (-1),
+      blockSize (jmax ((int) alignment, (blockSize_ / alignment) * alignment)),
+      block (nullptr),
+      blockStart (0),
+      numInBlock (0),
+      bypassingCache (false)
+{
+    if (! FilePositionalOutput::openedOk())
+        return;
+
+   #if JUCE_LINUX || JUCE_ANDROID
+    directHandle = open (file.getFullPathName().toUTF8(), O_WRONLY | O_DIRECT);
+    bypassingCache = directHandle >= 0;
+   #else
+    directHandle = open (file.getFullPathName().toUTF8(), O_WRONLY);
+
+    #if JUCE_MAC || JUCE_IOS
+    bypassingCache = directHandle >= 0 && fcntl (directHandle, F_NOCACHE, 1) != -1;
+    #endif
+   #endif
+
+    if (directHandle < 0)
+        return;
+
+    blockData.malloc ((size_t) (blockSize + alignment));
+    block = addBytesToPointer (blockData.getData(), alignment - ((pointer_sized_int) blockData.getData() & (alignment - 1)));
+
+    // the first block starts on the boundary before the current end, so bring in whatever's already there
+    blockStart = size & ~(int64) (alignment - 1);
+    numInBlock = (int) (size - blockStart);
+
+    if (numInBlock > 0 && FilePositionalOutput::readAt (blockStart, block, numInBlock) != numInBlock)
+    {
+        close (directHandle);
+        directHandle = -1;
+    }
+}
+
+DirectPositionalOutput::~DirectPositionalOutput()
+{
+    if (directHandle >= 0)
+    {
+        writeBlock();
+
+        // the last block was padded out to the alignment, so cut that back off
+        ftruncate (fileHandle, (off_t) size);
+        close (directHandle);
+    }
+}
+
+bool DirectPositionalOutput::writeAt (int64 position, const void* data, size_t numBytes)
+{
+    const char* source = static_cast<const char*> (data);
+    const int64 endPosition = position + (int64) numBytes;
+
+    // anything before the block has already gone to disk, so it's patched through the normal handle
+    if (position < blockStart)
+    {
+        const size_t numBeforeBlock = (size_t) jmin ((int64) numBytes, blockStart - position);
+
+        if (! writeToHandle (fileHandle, position, source, numBeforeBlock))
+            return false;
+
+        source += numBeforeBlock;
+        position += (int64) numBeforeBlock;
+        numBytes -= numBeforeBlock;
+    }
+
+    // a write that starts past the end of the block leaves a gap, which has to read as zeros
+    if (numBytes > 0 && position > blockStart + numInBlock && ! appendZeros (position - (blockStart + numInBlock)))
+        return false;
+
+    while (numBytes > 0)
+    {
+        const int offsetInBlock = (int) (position - blockStart);
+        const int numToCopy = (int) jmin ((int64) numBytes, (int64) (blockSize - offsetInBlock));
+
+        memcpy (block + offsetInBlock, source, (size_t) numToCopy);
+        numInBlock = jmax (numInBlock, offsetInBlock + numToCopy);
+
+        source += numToCopy;
+        position += numToCopy;
+        numBytes -= (size_t) numToCopy;
+
+        if (numInBlock == blockSize && ! moveToNextBlock())
+            return false;
+    }
+
+    size = jmax (size, endPosition);
+    return true;
+}
+
+int DirectPositionalOutput::readAt (int64 position, void* dest, int numBytes)
+{
+    numBytes = (int) jmin ((int64) numBytes, size - position);
+
+    if (numBytes <= 0)
+        return 0;
+
+    const int numBeforeBlock = (int) jlimit ((int64) 0, (int64) numBytes, blockStart - position);
+
+    if (numBeforeBlock > 0 && FilePositionalOutput::readAt (position, dest, numBeforeBlock) != numBeforeBlock)
+        return 0;
+
+    const int numInThisBlock = numBytes - numBeforeBlock;
+
+    if (numInThisBlock > 0)
+        memcpy (addBytesToPointer (dest, numBeforeBlock),
+                block + (position + numBeforeBlock - blockStart), (size_t) numInThisBlock);
+
+    return numBytes;
+}
+
+bool DirectPositionalOutput::growTo (int64 newSize)
+{
+    // the zeros only go into the block in memory, so this is no slower than extending the file
+    return newSize <= size || appendZeros (newSize - size);
+}
+
+bool DirectPositionalOutput::flush()
+{
+    const int64 paddedEnd = blockStart + ((numInBlock + alignment - 1) & ~(alignment - 1));
+
+    return writeBlock()
+            && (paddedEnd <= size || ftruncate (fileHandle, (off_t) size) == 0)
+            && fsync (directHandle) == 0;
+}
+
+bool DirectPositionalOutput::appendZeros (int64 numZeros)
+{
+    HeapBlock<char> zeros ((size_t) alignment, true);
+
+    while (numZeros > 0)
+    {
+        const int numToWrite = (int) jmin (numZeros, (int64) alignment);
+
+        if (! writeAt (blockStart + numInBlock, zeros, (size_t) numToWrite))
+            return false;
+
+        numZeros -= numToWrite;
+    }
+
+    return true;
+}
+
+bool DirectPositionalOutput::writeBlock()
+{
+    if (numInBlock == 0)
+        return true;
+
+    // direct writes have to be whole multiples of the alignment, so pad the last part out with zeros
+    const int numToWrite = (numInBlock + alignment - 1) & ~(alignment - 1);
+    zeromem (block + numInBlock, (size_t) (numToWrite - numInBlock));
+
+    if (bypassingCache)
+    {
+        if (writeToHandle (directHandle, blockStart, block, (size_t) numToWrite))
+            return true;
+
+        // some file systems accept O_DIRECT when opening but then refuse the writes, so
+        // there's no point trying it again for the blocks that follow
+        if (errno != EINVAL)
+            return false;
+
+        bypassingCache = false;
+    }
+
+    return writeToHandle (fileHandle, blockStart, block, (size_t) numToWrite);
+}
+
+bool DirectPositionalOutput::moveToNextBlock()
+{
+    if (! writeBlock())
+        return false;
+
+    blockStart += blockSize;
+    numInBlock = 0;
+    return true;
+}
+
+#endif
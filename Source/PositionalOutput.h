@@ -0,0 +1,295 @@
+/*
+  ==============================================================================
+
+    PositionalOutput.h
+    Created: 17 Oct 2026 9:04:18am
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __POSITIONALOUTPUT_H_2C7F90B4__
+#define __POSITIONALOUTPUT_H_2C7F90B4__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    A destination that blocks of data are written to at explicit offsets.
+
+    The AudioFile encoders write their audio sequentially but keep jumping back to
+    update the header. With a plain OutputStream every one of those jumps means a
+    flush and a seek, so this takes the offset with each call instead, which lets
+    the common case of appending to the end go straight through.
+
+    @see CoreAudioFormatNew
+*/
+class PositionalOutput
+{
+public:
+    //==============================================================================
+    virtual ~PositionalOutput() {}
+
+    /** The ways that growTo() can fill the space it adds. */
+    enum GrowthMode
+    {
+        writeZeros,         /**< Physically write zeros into the new space. */
+        allocateSpace       /**< Ask the file system for the space without writing anything to it. */
+    };
+
+    /** Writes a block of data at the given offset, returning false if it fails. */
+    virtual bool writeAt (int64 position, const void* data, size_t numBytes) = 0;
+
+    /** Reads back some data that has been written, returning the number of bytes read. */
+    virtual int readAt (int64 position, void* dest, int numBytes) = 0;
+
+    /** Extends the destination to the given size, so that the new space reads as zeros.
+        @see setGrowthMode
+    */
+    virtual bool growTo (int64 newSize) = 0;
+
+    /** Asks for space to be set aside for the destination to grow into, without
+        changing its size, so that a long recording is laid out contiguously.
+        Returns false if this kind of output can't do that.
+    */
+    virtual bool reserve (int64 /*totalSize*/)     { return false; }
+
+    /** Makes sure everything written so far has reached the destination. */
+    virtual bool flush() = 0;
+
+    /** Returns the number of bytes that have been written, including any padding. */
+    int64 getSize() const noexcept          { return size; }
+
+    /** Changes how growTo() fills new space. Outputs that can only write zeros ignore this. */
+    void setGrowthMode (GrowthMode newMode) noexcept    { growthMode = newMode; }
+
+    /** Returns true if the data is being written without going through the OS's file cache. */
+    virtual bool isBypassingCache() const noexcept      { return false; }
+
+    //==============================================================================
+    /** Creates the best PositionalOutput for a stream.
+
+        FileOutputStreams get one that writes to the file directly where the platform
+        allows it; anything else goes through the stream. The stream is not owned by
+        the object that is returned, and shouldn't be used while it exists.
+    */
+    static PositionalOutput* createFor (OutputStream& stream);
+
+    /** Creates a PositionalOutput that writes into a memory-mapped view of the file
+        that a FileOutputStream is writing to.
+
+        Returns nullptr if the stream isn't a FileOutputStream or the file can't be opened.
+        As with createFor(), the stream isn't owned by the object that is returned.
+        @see MappedPositionalOutput
+    */
+    static PositionalOutput* createMemoryMappedFor (OutputStream& stream);
+
+    /** Creates a PositionalOutput that hands writes for a FileOutputStream's file to the
+        OS or a background thread, so that the caller doesn't wait for the disk.
+
+        Returns nullptr if the stream isn't a FileOutputStream or the file can't be
+        opened, and always returns nullptr on Windows.
+        @see AsyncPositionalOutput
+    */
+    static PositionalOutput* createAsynchronousFor (OutputStream& stream);
+
+    /** Creates a PositionalOutput that writes a FileOutputStream's file in large aligned
+        blocks which bypass the OS's file cache.
+
+        Returns nullptr if the stream isn't a FileOutputStream or the file can't be opened.
+        @see DirectPositionalOutput
+    */
+    static PositionalOutput* createDirectFor (OutputStream& stream);
+
+protected:
+    //==============================================================================
+    PositionalOutput (int64 initialSize) noexcept : size (initialSize), growthMode (writeZeros) {}
+
+    int64 size;
+    GrowthMode growthMode;
+
+    /** If the stream is a FileOutputStream, this flushes it and returns it. */
+    static FileOutputStream* getFlushedFileStream (OutputStream& stream);
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (PositionalOutput);
+};
+
+//==============================================================================
+/**
+    A PositionalOutput that writes through an OutputStream.
+
+    The stream is only asked to seek when a write isn't at its current position.
+*/
+class StreamPositionalOutput  : public PositionalOutput
+{
+public:
+    StreamPositionalOutput (OutputStream& stream);
+
+    bool writeAt (int64 position, const void* data, size_t numBytes);
+    int readAt (int64 position, void* dest, int numBytes);
+    bool growTo (int64 newSize);
+    bool flush();
+
+private:
+    OutputStream& stream;
+    ScopedPointer<InputStream> input;   // used to read back from FileOutputStreams
+
+    bool seekTo (int64 position);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamPositionalOutput);
+};
+
+//==============================================================================
+/**
+    A PositionalOutput that writes to a file with pwrite(), so there's no stream
+    position to keep in step and nothing to flush before reading back.
+*/
+class FilePositionalOutput  : public PositionalOutput
+{
+public:
+    /** Opens the file for writing. Use openedOk() to find out if it worked. */
+    FilePositionalOutput (const File& file, int64 initialSize);
+    ~FilePositionalOutput();
+
+    bool openedOk() const noexcept          { return fileHandle >= 0; }
+
+    bool writeAt (int64 position, const void* data, size_t numBytes);
+    int readAt (int64 position, void* dest, int numBytes);
+    bool growTo (int64 newSize);
+    bool reserve (int64 totalSize);
+    bool flush();
+
+protected:
+    int fileHandle;
+    bool hasReservedSpace;
+
+    bool allocate (int64 start, int64 numBytes, bool keepSize);
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilePositionalOutput);
+};
+
+//==============================================================================
+/**
+    A PositionalOutput that maps the file into memory, so that writes, header
+    rewrites and reads back are all just memory copies.
+
+    The file is extended and re-mapped in large steps as it grows, and trimmed back
+    to the size that was actually written when this is deleted.
+*/
+class MappedPositionalOutput  : public FilePositionalOutput
+{
+public:
+    /** Opens the file. It isn't mapped until the first write, so that the growth
+        mode can be set first. Use openedOk() to find out if it worked.
+    */
+    MappedPositionalOutput (const File& file, int64 initialSize);
+    ~MappedPositionalOutput();
+
+    bool writeAt (int64 position, const void* data, size_t numBytes);
+    int readAt (int64 position, void* dest, int numBytes);
+    bool growTo (int64 newSize);
+    bool reserve (int64 totalSize);
+    bool flush();
+
+private:
+    void* mappedData;
+    int64 mappedSize;
+
+    bool ensureMapped (int64 requiredSize);
+    void unmap();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MappedPositionalOutput);
+};
+
+//==============================================================================
+/**
+    A PositionalOutput that queues its writes and returns straight away.
+
+    On Linux the writes are submitted with io_uring, which keeps several of them in
+    flight at once; on the Mac, or if io_uring isn't available, they are done in
+    order on a small thread pool that all the asynchronous outputs share. Either
+    way, a stall on one file doesn't hold up the thread that's feeding the others.
+
+    This needs pwrite(), so it isn't available on Windows: createAsynchronousFor()
+    returns nullptr there, and the writers write synchronously instead.
+
+    Calls to flush() queue an fsync behind the writes that are already pending,
+    rather than waiting for it. Errors from the background writes are reported by
+    the next call that's made. writeAt() only blocks when maxBytesInFlight is
+    already queued, and readAt() only blocks if it overlaps a pending write.
+*/
+class AsyncPositionalOutput  : public FilePositionalOutput
+{
+public:
+    /** Opens the file. Use openedOk() to find out if it worked. */
+    AsyncPositionalOutput (const File& file, int64 initialSize, int maxBytesInFlight = 4 * 1024 * 1024);
+    ~AsyncPositionalOutput();
+
+    bool writeAt (int64 position, const void* data, size_t numBytes);
+    int readAt (int64 position, void* dest, int numBytes);
+    bool flush();
+
+    /** Waits until everything that has been queued has been written.
+        Returns false if any of it failed.
+    */
+    bool waitForPendingWrites();
+
+    class Engine;
+
+private:
+    ScopedPointer<Engine> engine;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AsyncPositionalOutput);
+};
+
+//==============================================================================
+/**
+    A PositionalOutput for long recordings that are never read back, which keeps
+    them out of the OS's file cache.
+
+    Data is gathered into a page-aligned block in memory, and each block is written
+    with O_DIRECT (or F_NOCACHE on the Mac) once it's full. Writes that land in a
+    block that has already gone to disk, such as the header being updated, are
+    patched through a normal file handle. When this is deleted the last block is
+    padded out to the alignment, written, and the padding trimmed off again.
+
+    Some file systems let the file be opened with O_DIRECT but then refuse the
+    writes. If that happens, this carries on writing its blocks through the normal
+    handle, and isBypassingCache() starts returning false.
+*/
+class DirectPositionalOutput  : public FilePositionalOutput
+{
+public:
+    /** Opens the file. Use openedOk() to find out if it worked. */
+    DirectPositionalOutput (const File& file, int64 initialSize, int blockSize = 1024 * 1024);
+    ~DirectPositionalOutput();
+
+    bool openedOk() const noexcept          { return FilePositionalOutput::openedOk() && directHandle >= 0; }
+
+    bool writeAt (int64 position, const void* data, size_t numBytes);
+    int readAt (int64 position, void* dest, int numBytes);
+    bool growTo (int64 newSize);
+    bool flush();
+    bool isBypassingCache() const noexcept  { return bypassingCache; }
+
+private:
+    enum { alignment = 4096 };
+
+    int directHandle;
+    const int blockSize;
+    HeapBlock<char> blockData;
+    char* block;                // blockData, rounded up to the alignment
+    int64 blockStart;
+    int numInBlock;
+    bool bypassingCache;        // false once the direct writes have had to be given up
+
+    bool appendZeros (int64 numZeros);
+    bool writeBlock();
+    bool moveToNextBlock();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DirectPositionalOutput);
+};
+
+#endif  // __POSITIONALOUTPUT_H_2C7F90B4__
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    PreRollBuffer.cpp
+    Created: 17 Oct 2026 11:08:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "PreRollBuffer.h"
+
+//==============================================================================
+PreRollBuffer::PreRollBuffer (int numChannels, int numSamples)
+    : buffer (jmax (1, numChannels), jmax (1, numSamples)),
+      writePosition (0),
+      reservedPosition (0)
+{
+    buffer.clear();
+}
+
+PreRollBuffer::~PreRollBuffer()
+{
+}
+
+//==============================================================================
+void PreRollBuffer::write (const float* const* source, int numSourceChannels, int numSamples) noexcept
+{
+    const int capacity = buffer.getNumSamples();
+
+    // only the newest samples of a block that's bigger than the buffer would survive anyway
+    const int sourceOffset = jmax (0, numSamples - capacity);
+    numSamples -= sourceOffset;
+
+    if (numSamples <= 0)
+        return;
+
+    const int64 start = writePosition.get() + sourceOffset;
+
+    // readers check this afterwards, to see whether we've been writing over what they read
+    reservedPosition = start + numSamples;
+    Atomic<int>::memoryBarrier();
+
+    const int startIndex = (int) (start % capacity);
+    const int size1 = jmin (numSamples, capacity - startIndex);
+    const int size2 = numSamples - size1;
+
+    for (int i = buffer.getNumChannels(); --i >= 0;)
+    {
+        if (i < numSourceChannels && source[i] != nullptr)
+        {
+            buffer.copyFrom (i, startIndex, source[i] + sourceOffset, size1);
+
+            if (size2 > 0)
+                buffer.copyFrom (i, 0, source[i] + sourceOffset + size1, size2);
+        }
+        else
+        {
+            buffer.clear (i, startIndex, size1);
+
+            if (size2 > 0)
+                buffer.clear (i, 0, size2);
+        }
+    }
+
+    Atomic<int>::memoryBarrier();
+    writePosition = start + numSamples;
+}
+
+int64 PreRollBuffer::getOldestPosition() const noexcept
+{
+    return jmax ((int64) 0, reservedPosition.get() - buffer.getNumSamples());
+}
+
+bool PreRollBuffer::read (int64 startPosition, AudioSampleBuffer& dest, int destStartSample, int numSamples) const noexcept
+{
+    const int capacity = buffer.getNumSamples();
+
+    if (numSamples <= 0)
+        return true;
+
+    if (startPosition < getOldestPosition() || startPosition + numSamples > writePosition.get())
+        return false;
+
+    Atomic<int>::memoryBarrier();
+
+    const int startIndex = (int) (startPosition % capacity);
+    const int size1 = jmin (numSamples, capacity - startIndex);
+    const int size2 = numSamples - size1;
+    const int numChannels = jmin (buffer.getNumChannels(), dest.getNumChannels());
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        dest.copyFrom (i, destStartSample, buffer, i, startIndex, size1);
+
+        if (size2 > 0)
+            dest.copyFrom (i, destStartSample + size1, buffer, i, 0, size2);
+    }
+
+    for (int i = numChannels; i < dest.getNumChannels(); ++i)
+        dest.clear (i, destStartSample, numSamples);
+
+    // if the writer has got round to any of what we copied in the meantime, it's no good
+    Atomic<int>::memoryBarrier();
+    return startPosition >= getOldestPosition();
+}
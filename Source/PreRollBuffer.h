@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    PreRollBuffer.h
+    Created: 17 Oct 2026 11:08:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __PREROLLBUFFER_H_2D9F47C1__
+#define __PREROLLBUFFER_H_2D9F47C1__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    A circular buffer that always holds the most recent samples that have been
+    written to it, so that a recording can start from a little before it was asked to.
+
+    One thread (normally the audio callback) writes to it all the time, overwriting
+    the oldest samples. Writing never blocks or allocates. Any other thread can copy
+    samples out while that's going on: each sample has a position, counting from
+    the first one ever written, and read() says whether the samples it was asked
+    for were all still there.
+*/
+class PreRollBuffer
+{
+public:
+    //==============================================================================
+    /** Creates a buffer that holds the last numSamples samples of each channel. */
+    PreRollBuffer (int numChannels, int numSamples);
+
+    /** Destructor. */
+    ~PreRollBuffer();
+
+    //==============================================================================
+    /** Adds some samples, overwriting the oldest ones if the buffer's full. This must
+        only be called by one thread.
+
+        Any of the buffer's channels that aren't in the source are filled with silence,
+        as are any for which the source has a null pointer.
+    */
+    void write (const float* const* source, int numSourceChannels, int numSamples) noexcept;
+
+    /** Returns the position that the next sample written will have. */
+    int64 getWritePosition() const noexcept         { return writePosition.get(); }
+
+    /** Returns the position of the oldest sample that's still in the buffer. */
+    int64 getOldestPosition() const noexcept;
+
+    /** Copies some samples out of the buffer.
+
+        This can be called from any thread, even while samples are being written.
+        @returns false if some of the samples have already been overwritten, or haven't
+                 been written yet, in which case the destination holds rubbish
+    */
+    bool read (int64 startPosition, AudioSampleBuffer& dest, int destStartSample, int numSamples) const noexcept;
+
+    //==============================================================================
+    /** Returns the most samples the buffer can hold. */
+    int getCapacity() const noexcept                { return buffer.getNumSamples(); }
+
+    /** Returns the number of channels. */
+    int getNumChannels() const noexcept             { return buffer.getNumChannels(); }
+
+private:
+    //==============================================================================
+    AudioSampleBuffer buffer;
+    Atomic<int64> writePosition;    // where the samples that have been written end
+    Atomic<int64> reservedPosition; // where the samples that are being written end
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PreRollBuffer);
+};
+
+
+#endif  // __PREROLLBUFFER_H_2D9F47C1__
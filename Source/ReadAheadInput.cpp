@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+    ReadAheadInput.cpp
+    Created: 17 Oct 2026 4:37:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "ReadAheadInput.h"
+#include "ConcurrencyHelpers.h"
+
+//==============================================================================
+namespace
+{
+    ThreadPool* createReadAheadPool()   { return new ThreadPool (2); }
+
+    LazySingleton<ThreadPool> sharedReadAheadPool (createReadAheadPool);
+
+    ThreadPool& getSharedReadAheadPool()
+    {
+        return sharedReadAheadPool.get();
+    }
+
+    /** The number of reads in a row that have to carry on from each other before
+        the blocks after them start being fetched.
+    */
+    const int minimumSequentialRun = 2;
+}
+
+//==============================================================================
+ReadAheadInput::Block::Block (int size)
+    : data ((size_t) size), start (0), numBytes (0), state (empty), lastUsed (0)
+{
+}
+
+//==============================================================================
+ReadAheadInput::ReadAheadInput (InputStream& source_, int blockSize_, int numCachedBlocks, int readAheadBytes)
+    : ThreadPoolJob ("Read-ahead"),
+      source (source_),
+      blockSize (jmax (1, blockSize_)),
+      numBlocksToReadAhead (jmax (0, (readAheadBytes + blockSize - 1) / blockSize)),
+      totalLength (source_.getTotalLength()),
+      useCounter (0),
+      isQueuedOnPool (false),
+      nextSequentialPosition (-1),
+      sequentialRunLength (0)
+{
+    // there's one extra block for the one being read from while the ones after it are fetched
+    const int numBlocks = jmax (1, numCachedBlocks) + (numBlocksToReadAhead > 0 ? numBlocksToReadAhead + 1 : 0);
+
+    for (int i = 0; i < numBlocks; ++i)
+        blocks.add (new Block (blockSize));
+}
+
+ReadAheadInput::~ReadAheadInput()
+{
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = prefetchQueue.size(); --i >= 0;)
+            prefetchQueue.getUnchecked (i)->state = Block::empty;
+
+        prefetchQueue.clear();
+    }
+
+    getSharedReadAheadPool().waitForJobToFinish (this, -1);
+}
+
+//==============================================================================
+int ReadAheadInput::readAt (int64 position, void* dest, int numBytes)
+{
+    if (position < 0 || position >= totalLength || numBytes <= 0)
+        return 0;
+
+    numBytes = (int) jmin ((int64) numBytes, totalLength - position);
+
+    // nothing else touches these, so they don't need the lock
+    sequentialRunLength = (position == nextSequentialPosition) ? sequentialRunLength + 1 : 0;
+    nextSequentialPosition = position + numBytes;
+
+    // a big read somewhere new would only push everything else out of the cache
+    if (sequentialRunLength == 0 && numBytes >= blockSize)
+        return readFromSource (position, dest, numBytes);
+
+    char* const destData = static_cast<char*> (dest);
+    int numRead = 0;
+
+    while (numRead < numBytes)
+    {
+        const int64 readPosition = position + numRead;
+        const Block* const block = waitForBlock (readPosition - readPosition % blockSize);
+
+        if (block == nullptr)
+        {
+            numRead += readFromSource (readPosition, destData + numRead, numBytes - numRead);
+            break;
+        }
+
+        const int offsetInBlock = (int) (readPosition - block->start);
+        const int numToCopy = jmin (numBytes - numRead, block->numBytes - offsetInBlock);
+
+        if (numToCopy <= 0)
+            break;
+
+        memcpy (destData + numRead, block->data + offsetInBlock, (size_t) numToCopy);
+        numRead += numToCopy;
+    }
+
+    if (sequentialRunLength >= minimumSequentialRun && numBlocksToReadAhead > 0)
+        scheduleReadAhead (position + numRead);
+
+    return numRead;
+}
+
+//==============================================================================
+ReadAheadInput::Block* ReadAheadInput::findBlock (int64 start) const noexcept
+{
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        Block* const block = blocks.getUnchecked (i);
+
+        if (block->state != Block::empty && block->start == start)
+            return block;
+    }
+
+    return nullptr;
+}
+
+ReadAheadInput::Block* ReadAheadInput::findLeastRecentlyUsed() const noexcept
+{
+    Block* best = nullptr;
+
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        Block* const block = blocks.getUnchecked (i);
+
+        if (block->state == Block::empty)
+            return block;
+
+        if (block->state == Block::ready && (best == nullptr || block->lastUsed < best->lastUsed))
+            best = block;
+    }
+
+    return best;
+}
+
+ReadAheadInput::Block* ReadAheadInput::waitForBlock (int64 start)
+{
+    // only this thread ever claims blocks, so once a block is ready its contents stay
+    // put until this thread moves it somewhere else
+    for (;;)
+    {
+        Block* block;
+
+        {
+            const ScopedLock sl (lock);
+            block = findBlock (start);
+
+            if (block != nullptr && block->state == Block::ready)
+            {
+                block->lastUsed = ++useCounter;
+                return block;
+            }
+
+            if (block == nullptr)
+            {
+                block = findLeastRecentlyUsed();
+
+                if (block == nullptr)
+                    return nullptr;
+
+                block->start = start;
+                block->state = Block::loading;
+            }
+            else if (block->state == Block::queued)
+            {
+                // the background thread hasn't got to this one yet, so don't wait for it
+                prefetchQueue.removeFirstMatchingValue (block);
+                block->state = Block::loading;
+            }
+            else
+            {
+                block = nullptr;
+            }
+        }
+
+        if (block == nullptr)
+        {
+            blockLoaded.wait (50);
+            continue;
+        }
+
+        const int numExpected = (int) jmin ((int64) blockSize, totalLength - start);
+        const int numRead = readFromSource (start, block->data, numExpected);
+
+        const ScopedLock sl (lock);
+        block->numBytes = numRead;
+        block->lastUsed = ++useCounter;
+
+        // a block that came up short is handed back for this read, but isn't kept
+        block->state = (numRead == numExpected) ? Block::ready : Block::empty;
+        return block;
+    }
+}
+
+void ReadAheadInput::scheduleReadAhead (int64 position)
+{
+    const ScopedLock sl (lock);
+
+    const int64 end = jmin (totalLength, position + (int64) numBlocksToReadAhead * blockSize);
+
+    for (int64 start = position - position % blockSize; start < end; start += blockSize)
+    {
+        if (findBlock (start) != nullptr)
+            continue;
+
+        Block* const block = findLeastRecentlyUsed();
+
+        if (block == nullptr)
+            break;
+
+        block->start = start;
+        block->state = Block::queued;
+        block->lastUsed = ++useCounter;
+        prefetchQueue.add (block);
+    }
+
+    if (prefetchQueue.size() > 0)
+        requeueDrainingJob (getSharedReadAheadPool(), this, isQueuedOnPool);
+}
+
+int ReadAheadInput::readFromSource (int64 position, void* dest, int numBytes)
+{
+    const ScopedLock sl (streamLock);
+
+    if (! source.setPosition (position))
+        return 0;
+
+    return source.read (dest, numBytes);
+}
+
+ThreadPoolJob::JobStatus ReadAheadInput::runJob()
+{
+    for (;;)
+    {
+        Block* block;
+
+        {
+            const ScopedLock sl (lock);
+
+            if (prefetchQueue.size() == 0)
+            {
+                isQueuedOnPool = false;
+                blockLoaded.signal();
+                return jobHasFinished;
+            }
+
+            block = prefetchQueue.getUnchecked (0);
+            prefetchQueue.remove (0);
+            block->state = Block::loading;
+        }
+
+        const int numExpected = (int) jmin ((int64) blockSize, totalLength - block->start);
+        const int numRead = readFromSource (block->start, block->data, numExpected);
+
+        {
+            const ScopedLock sl (lock);
+            block->numBytes = numRead;
+            block->state = (numRead == numExpected) ? Block::ready : Block::empty;
+        }
+
+        blockLoaded.signal();
+    }
+}
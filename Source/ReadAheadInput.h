@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    ReadAheadInput.h
+    Created: 17 Oct 2026 4:37:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __READAHEADINPUT_H_91D4E6A2__
+#define __READAHEADINPUT_H_91D4E6A2__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    Serves reads at explicit offsets from an InputStream out of a set of blocks held
+    in memory.
+
+    The AudioFile parsers ask for lots of small pieces of a file, mostly one after the
+    other. Rather than seeking and reading the stream for each of those, this reads
+    it a whole block at a time, and keeps the most recently used blocks around so that
+    parsers that hop about the file, e.g. between its header and its packet table,
+    only touch the stream once per block.
+
+    Once reads have been carrying on from each other for a while, the blocks after
+    them are fetched on a background thread, so that by the time the parser gets to
+    them they're already in memory. On slow disks and network shares that keeps the
+    parser from ever waiting for the stream while it's reading straight through.
+
+    The stream isn't owned by this object, and mustn't be used by anything else while
+    it exists.
+
+    @see CoreAudioFormatNew
+*/
+class ReadAheadInput  : private ThreadPoolJob
+{
+public:
+    //==============================================================================
+    /** Creates a ReadAheadInput for a stream.
+
+        @param source           the stream to read from
+        @param blockSize        the number of bytes read from the stream at a time
+        @param numCachedBlocks  the number of blocks kept for reads that jump about
+        @param readAheadBytes   how far ahead of a sequential run of reads the blocks
+                                are fetched in the background. 0 turns this off,
+                                leaving just the block cache
+    */
+    ReadAheadInput (InputStream& source, int blockSize, int numCachedBlocks, int readAheadBytes);
+
+    /** Destructor. Waits for any block that's being fetched to arrive. */
+    ~ReadAheadInput();
+
+    //==============================================================================
+    /** Reads some data from the given offset, returning the number of bytes read.
+        This will only be less than numBytes at the end of the stream.
+    */
+    int readAt (int64 position, void* dest, int numBytes);
+
+    /** Returns the length of the stream. */
+    int64 getTotalLength() const noexcept       { return totalLength; }
+
+private:
+    //==============================================================================
+    struct Block
+    {
+        Block (int size);
+
+        enum State { empty, queued, loading, ready };
+
+        HeapBlock<char> data;
+        int64 start;
+        int numBytes;
+        State state;
+        uint32 lastUsed;
+    };
+
+    InputStream& source;
+    const int blockSize, numBlocksToReadAhead;
+    const int64 totalLength;
+    OwnedArray<Block> blocks;
+
+    CriticalSection lock;           // guards the blocks' states, the queue and the use counter
+    CriticalSection streamLock;     // held by whichever thread is reading from the source
+    WaitableEvent blockLoaded;
+    Array<Block*> prefetchQueue;
+    uint32 useCounter;
+    bool isQueuedOnPool;
+
+    int64 nextSequentialPosition;
+    int sequentialRunLength;
+
+    Block* findBlock (int64 start) const noexcept;
+    Block* findLeastRecentlyUsed() const noexcept;
+    Block* waitForBlock (int64 start);
+    void scheduleReadAhead (int64 position);
+    int readFromSource (int64 position, void* dest, int numBytes);
+    JobStatus runJob();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReadAheadInput);
+};
+
+
+#endif  // __READAHEADINPUT_H_91D4E6A2__
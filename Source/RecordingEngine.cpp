@@ -0,0 +1,346 @@
+/*
+  ==============================================================================
+
+    RecordingEngine.cpp
+    Created: 17 Oct 2026 10:26:13pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "RecordingEngine.h"
+
+#if ! JUCE_WINDOWS
+ #include <sys/stat.h>
+#endif
+
+//==============================================================================
+namespace
+{
+    /** How long a writer thread waits when none of its FIFOs has a full block in it,
+        before it writes out whatever they have got.
+    */
+    const int idleIntervalMs = 5;
+
+    /** Returns a string that's the same for all the files on one disk. */
+    String getDiskIdentifier (const File& file)
+    {
+        const File folder (file.getParentDirectory());
+
+       #if JUCE_WINDOWS
+        return String (folder.getVolumeSerialNumber());
+       #else
+        struct stat info;
+
+        if (stat (folder.getFullPathName().toUTF8(), &info) == 0)
+            return String ((int64) info.st_dev);
+
+        return String::empty;
+       #endif
+    }
+}
+
+//==============================================================================
+/** The streams that are being recorded to one disk, and the threads that write them. */
+class RecordingEngine::Disk
+{
+public:
+    Disk (RecordingEngine& owner, const String& identifier_);
+    ~Disk();
+
+    /** Finds the fullest stream that has at least minimumSamples ready, and marks it as
+        being written so that the disk's other threads leave it alone.
+    */
+    Stream* claimFullestStream (int minimumSamples)
+    {
+        const ScopedLock sl (lock);
+
+        Stream* fullest = nullptr;
+        float fullestLevel = 0;
+
+        for (int i = streams.size(); --i >= 0;)
+        {
+            Stream* const stream = streams.getUnchecked (i);
+
+            if (stream->isBeingWritten || stream->fifo.getNumReady() < minimumSamples)
+                continue;
+
+            const float level = stream->getFillLevel();
+
+            if (fullest == nullptr || level > fullestLevel)
+            {
+                fullest = stream;
+                fullestLevel = level;
+            }
+        }
+
+        if (fullest != nullptr)
+            fullest->isBeingWritten = true;
+
+        return fullest;
+    }
+
+    void releaseStream (Stream* stream)
+    {
+        {
+            const ScopedLock sl (lock);
+            stream->isBeingWritten = false;
+        }
+
+        streamReleased.signal();
+    }
+
+    void addStream (Stream* stream)
+    {
+        const ScopedLock sl (lock);
+        streams.add (stream);
+    }
+
+    bool hasStream (Stream* stream) const
+    {
+        const ScopedLock sl (lock);
+        return streams.contains (stream);
+    }
+
+    /** Takes a stream off the disk, waiting for any thread that's writing it to finish. */
+    bool removeStream (Stream* stream)
+    {
+        for (;;)
+        {
+            {
+                const ScopedLock sl (lock);
+
+                if (! streams.contains (stream))
+                    return false;
+
+                if (! stream->isBeingWritten)
+                {
+                    streams.removeFirstMatchingValue (stream);
+                    return true;
+                }
+            }
+
+            streamReleased.wait (idleIntervalMs);
+        }
+    }
+
+    const String identifier;
+
+private:
+    CriticalSection lock;
+    Array<Stream*> streams;
+    WaitableEvent streamReleased;
+    OwnedArray<DiskThread> threads;
+
+    JUCE_DECLARE_NON_COPYABLE (Disk);
+};
+
+//==============================================================================
+/** Keeps writing the fullest FIFO on its disk. */
+class RecordingEngine::DiskThread  : public Thread
+{
+public:
+    DiskThread (Disk& disk_, int blockSize_)
+        : Thread ("Recording disk writer"),
+          disk (disk_), blockSize (blockSize_)
+    {
+    }
+
+    ~DiskThread()
+    {
+        stopThread (10000);
+    }
+
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            Stream* stream = disk.claimFullestStream (blockSize);
+
+            // when nothing's got a whole block, give them a moment and then write what there is
+            if (stream == nullptr)
+            {
+                wait (idleIntervalMs);
+
+                if (threadShouldExit())
+                    break;
+
+                stream = disk.claimFullestStream (1);
+            }
+
+            if (stream != nullptr)
+            {
+                stream->writeReadySamples();
+                disk.releaseStream (stream);
+            }
+        }
+    }
+
+private:
+    Disk& disk;
+    const int blockSize;
+
+    JUCE_DECLARE_NON_COPYABLE (DiskThread);
+};
+
+//==============================================================================
+RecordingEngine::Disk::Disk (RecordingEngine& owner, const String& identifier_)
+    : identifier (identifier_)
+{
+    for (int i = 0; i < owner.threadsPerDisk; ++i)
+        threads.add (new DiskThread (*this, owner.blockSize))->startThread (7);
+}
+
+RecordingEngine::Disk::~Disk()
+{
+    for (int i = threads.size(); --i >= 0;)
+        threads.getUnchecked (i)->signalThreadShouldExit();
+
+    threads.clear();
+}
+
+//==============================================================================
+RecordingEngine::Stream::Stream (AudioFormatWriter* writer_, const File& file_, int fifoSize)
+    : writer (writer_),
+      fifo ((int) writer_->getNumChannels(), fifoSize),
+      file (file_),
+      isBeingWritten (false)
+{
+}
+
+RecordingEngine::Stream::~Stream()
+{
+}
+
+bool RecordingEngine::Stream::write (const float* const* data, int numChannels, int numSamples) noexcept
+{
+    return fifo.write (data, numChannels, numSamples);
+}
+
+float RecordingEngine::Stream::getFillLevel() const noexcept
+{
+    return fifo.getNumReady() / (float) fifo.getCapacity();
+}
+
+int RecordingEngine::Stream::writeReadySamples()
+{
+    const int numWritten = fifo.writeTo (*writer, fifo.getNumReady());
+
+    if (numWritten < 0)
+    {
+        writeFailed = 1;
+        return 0;
+    }
+
+    numSamplesWritten += (int64) numWritten;
+    return numWritten;
+}
+
+//==============================================================================
+RecordingEngine::RecordingEngine (int threadsPerDisk_, int blockSize_)
+    : threadsPerDisk (jmax (1, threadsPerDisk_)),
+      blockSize (jmax (1, blockSize_))
+{
+}
+
+RecordingEngine::~RecordingEngine()
+{
+    while (getNumStreams() > 0)
+        stopRecording (streams.getLast());
+
+    disks.clear();
+}
+
+//==============================================================================
+RecordingEngine::Stream* RecordingEngine::startRecording (const File& file, AudioFormat& format, double sampleRate,
+                                                          int numChannels, int bitsPerSample, int fifoSize)
+{
+    file.deleteFile();
+    ScopedPointer<FileOutputStream> fileStream (file.createOutputStream());
+
+    if (fileStream == nullptr)
+        return nullptr;
+
+    AudioFormatWriter* const writer = format.createWriterFor (fileStream, sampleRate, (unsigned int) numChannels,
+                                                              bitsPerSample, StringPairArray(), 0);
+    if (writer == nullptr)
+        return nullptr;
+
+    fileStream.release();
+
+    Stream* const stream = new Stream (writer, file, fifoSize);
+
+    const ScopedLock sl (lock);
+    streams.add (stream);
+    getDiskFor (file)->addStream (stream);
+
+    return stream;
+}
+
+void RecordingEngine::stopRecording (Stream* stream)
+{
+    Disk* disk = nullptr;
+
+    {
+        const ScopedLock sl (lock);
+
+        if (! streams.contains (stream))
+            return;
+
+        streams.removeFirstMatchingValue (stream);
+
+        for (int i = disks.size(); --i >= 0;)
+        {
+            if (disks.getUnchecked (i)->hasStream (stream))
+            {
+                disk = disks.getUnchecked (i);
+                break;
+            }
+        }
+    }
+
+    // this can wait for a whole block to be written, so the other streams mustn't be held up by it
+    if (disk != nullptr)
+        disk->removeStream (stream);
+
+    // none of the writer threads can see it now, so whatever's left is written here
+    while (stream->writeReadySamples() > 0)
+    {}
+
+    delete stream;
+}
+
+//==============================================================================
+int RecordingEngine::getNumStreams() const
+{
+    const ScopedLock sl (lock);
+    return streams.size();
+}
+
+int RecordingEngine::getNumDisks() const
+{
+    const ScopedLock sl (lock);
+    return disks.size();
+}
+
+int64 RecordingEngine::getNumSamplesDropped() const
+{
+    const ScopedLock sl (lock);
+    int64 total = 0;
+
+    for (int i = streams.size(); --i >= 0;)
+        total += streams.getUnchecked (i)->getNumSamplesDropped();
+
+    return total;
+}
+
+RecordingEngine::Disk* RecordingEngine::getDiskFor (const File& file)
+{
+    const String identifier (getDiskIdentifier (file));
+
+    for (int i = disks.size(); --i >= 0;)
+        if (disks.getUnchecked (i)->identifier == identifier)
+            return disks.getUnchecked (i);
+
+    return disks.add (new Disk (*this, identifier));
+}
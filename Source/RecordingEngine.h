@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    RecordingEngine.h
+    Created: 17 Oct 2026 10:26:13pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __RECORDINGENGINE_H_A41D6E38__
+#define __RECORDINGENGINE_H_A41D6E38__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "RecordingFifo.h"
+
+//==============================================================================
+/**
+    Records lots of separate files at once, e.g. one for each track of a session.
+
+    Each file being recorded is a Stream, which has its own RecordingFifo that the
+    audio thread writes to. The FIFOs are emptied into the files by a few writer
+    threads for each disk, so adding more files doesn't add more threads, and a slow
+    disk only holds up the files that are on it. The writer threads always go for
+    the fullest FIFO on their disk first, so the streams that are closest to
+    overflowing get written before the ones that can wait.
+
+    @see CoreAudioFormatNew
+*/
+class RecordingEngine
+{
+public:
+    //==============================================================================
+    /** Creates an engine.
+
+        @param threadsPerDisk   the number of writer threads to run for each disk
+                                that's being recorded to
+        @param blockSize        the number of samples a FIFO has to have in it before
+                                it's worth a trip to the disk. Emptier FIFOs are
+                                still written every few milliseconds
+    */
+    explicit RecordingEngine (int threadsPerDisk = 1, int blockSize = 16384);
+
+    /** Destructor. This stops any streams that are still recording. */
+    ~RecordingEngine();
+
+    //==============================================================================
+    /** A file that's being recorded. */
+    class Stream
+    {
+    public:
+        /** Adds some samples to the stream's FIFO.
+
+            This is wait-free, and is meant to be called from the audio thread. Only
+            one thread may write to a stream.
+            @returns false if the FIFO was full, in which case the samples are dropped
+        */
+        bool write (const float* const* data, int numChannels, int numSamples) noexcept;
+
+        /** Returns the file being recorded. */
+        const File& getFile() const noexcept                { return file; }
+
+        /** Returns the number of samples that have been written to the file. */
+        int64 getNumSamplesWritten() const noexcept         { return numSamplesWritten.get(); }
+
+        /** Returns the number of samples that have been dropped because the FIFO was full. */
+        int64 getNumSamplesDropped() const noexcept         { return fifo.getNumSamplesDropped(); }
+
+        /** Returns true if the writer has failed to write some samples. */
+        bool hasWriteFailed() const noexcept                { return writeFailed.get() != 0; }
+
+        /** Returns how full the FIFO is, from 0 to 1. */
+        float getFillLevel() const noexcept;
+
+    private:
+        friend class RecordingEngine;
+
+        Stream (AudioFormatWriter* writer, const File& file, int fifoSize);
+        ~Stream();
+
+        int writeReadySamples();
+
+        ScopedPointer<AudioFormatWriter> writer;
+        RecordingFifo fifo;
+        const File file;
+        Atomic<int64> numSamplesWritten;
+        Atomic<int> writeFailed;
+        bool isBeingWritten;    // guarded by the disk's lock
+
+        JUCE_DECLARE_NON_COPYABLE (Stream);
+    };
+
+    //==============================================================================
+    /** Starts recording a file, replacing it if it already exists.
+
+        The writer is created by the given format, so for a CoreAudioFormatNew it uses
+        whatever WriterOptions that's been given.
+        @returns the new stream, or nullptr if the file or writer couldn't be created
+    */
+    Stream* startRecording (const File& file, AudioFormat& format, double sampleRate,
+                            int numChannels, int bitsPerSample, int fifoSize = 65536);
+
+    /** Stops a stream, writes whatever's left in its FIFO to the file, and deletes it.
+
+        Make sure that the audio thread has finished writing to the stream before
+        calling this, as the stream is gone when it returns.
+    */
+    void stopRecording (Stream* stream);
+
+    //==============================================================================
+    /** Returns the number of streams that are recording. */
+    int getNumStreams() const;
+
+    /** Returns the number of disks that the engine has writer threads for. */
+    int getNumDisks() const;
+
+    /** Returns the total number of samples that have been dropped by all the streams
+        that are recording now.
+    */
+    int64 getNumSamplesDropped() const;
+
+private:
+    //==============================================================================
+    class Disk;
+    class DiskThread;
+
+    const int threadsPerDisk, blockSize;
+    CriticalSection lock;
+    OwnedArray<Disk> disks;
+    Array<Stream*> streams;
+
+    Disk* getDiskFor (const File& file);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RecordingEngine);
+};
+
+
+#endif  // __RECORDINGENGINE_H_A41D6E38__
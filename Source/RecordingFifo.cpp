@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    RecordingFifo.cpp
+    Created: 17 Oct 2026 9:47:30pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "RecordingFifo.h"
+
+//==============================================================================
+RecordingFifo::RecordingFifo (int numChannels, int numSamples)
+    : fifo (jmax (1, numSamples) + 1),     // an AbstractFifo holds one less than its size
+      buffer (jmax (1, numChannels), jmax (1, numSamples) + 1)
+{
+    buffer.clear();
+}
+
+RecordingFifo::~RecordingFifo()
+{
+}
+
+//==============================================================================
+bool RecordingFifo::write (const float* const* source, int numSourceChannels, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return true;
+
+    if (fifo.getFreeSpace() < numSamples)
+    {
+        numSamplesDropped += (int64) numSamples;
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    copyIn (source, numSourceChannels, 0, start1, size1);
+    copyIn (source, numSourceChannels, size1, start2, size2);
+
+    fifo.finishedWrite (size1 + size2);
+    return true;
+}
+
+int RecordingFifo::writeTo (AudioFormatWriter& writer, int maxSamples)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (jmax (0, maxSamples), start1, size1, start2, size2);
+
+    const bool ok = (size1 <= 0 || writer.writeFromAudioSampleBuffer (buffer, start1, size1))
+                     && (size2 <= 0 || writer.writeFromAudioSampleBuffer (buffer, start2, size2));
+
+    // the samples are used up either way, so that a failing writer can't stall the producer
+    fifo.finishedRead (size1 + size2);
+    return ok ? size1 + size2 : -1;
+}
+
+//==============================================================================
+void RecordingFifo::copyIn (const float* const* source, int numSourceChannels, int sourceOffset,
+                            int destStart, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    for (int i = buffer.getNumChannels(); --i >= 0;)
+    {
+        if (i < numSourceChannels && source[i] != nullptr)
+            buffer.copyFrom (i, destStart, source[i] + sourceOffset, numSamples);
+        else
+            buffer.clear (i, destStart, numSamples);
+    }
+}
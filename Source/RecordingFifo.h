@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    RecordingFifo.h
+    Created: 17 Oct 2026 9:47:30pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __RECORDINGFIFO_H_7C2E5B94__
+#define __RECORDINGFIFO_H_7C2E5B94__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    A wait-free FIFO of multichannel audio, with one thread putting samples in and
+    one other thread taking them out.
+
+    This is for getting audio from a device callback to a thread that writes it to
+    disk. Neither side ever blocks, takes a lock or allocates. Samples that don't
+    fit when the FIFO is full are thrown away and counted, rather than making the
+    audio thread wait.
+*/
+class RecordingFifo
+{
+public:
+    //==============================================================================
+    /** Creates a FIFO that can hold up to numSamples samples of each channel. */
+    RecordingFifo (int numChannels, int numSamples);
+
+    /** Destructor. */
+    ~RecordingFifo();
+
+    //==============================================================================
+    /** Adds some samples to the FIFO. This must only be called by the producer thread.
+
+        Any of the FIFO's channels that aren't in the source are filled with silence,
+        as are any for which the source has a null pointer.
+        @returns false if there wasn't room for all the samples, in which case
+                 none of them are added
+    */
+    bool write (const float* const* source, int numSourceChannels, int numSamples) noexcept;
+
+    /** Takes up to maxSamples samples out of the FIFO and passes them to a writer. This
+        must only be called by the consumer thread.
+        @returns the number of samples written, or -1 if the writer failed, in which
+                 case the samples are still taken out
+    */
+    int writeTo (AudioFormatWriter& writer, int maxSamples);
+
+    //==============================================================================
+    /** Returns the number of samples waiting to be taken out. */
+    int getNumReady() const noexcept            { return fifo.getNumReady(); }
+
+    /** Returns the number of samples that could be added now. */
+    int getFreeSpace() const noexcept           { return fifo.getFreeSpace(); }
+
+    /** Returns the most samples the FIFO can hold. */
+    int getCapacity() const noexcept            { return fifo.getTotalSize() - 1; }
+
+    /** Returns the number of channels. */
+    int getNumChannels() const noexcept         { return buffer.getNumChannels(); }
+
+    /** Returns the number of samples that have been thrown away because the FIFO
+        was full when they arrived.
+    */
+    int64 getNumSamplesDropped() const noexcept { return numSamplesDropped.get(); }
+
+private:
+    //==============================================================================
+    AbstractFifo fifo;
+    AudioSampleBuffer buffer;
+    Atomic<int64> numSamplesDropped;
+
+    void copyIn (const float* const* source, int numSourceChannels, int sourceOffset,
+                 int destStart, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RecordingFifo);
+};
+
+
+#endif  // __RECORDINGFIFO_H_7C2E5B94__
@@ -0,0 +1,1268 @@
+/*
+  ==============================================================================
+
+    SampleConversion.cpp
+    Created: 17 Oct 2026 2:36:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#include "SampleConversion.h"
+
+#if (defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define JUCE_SAMPLECONVERSION_USE_SSE2 1
+ #include <emmintrin.h>
+#elif (defined (__ARM_NEON__) || defined (__ARM_NEON))
+ #define JUCE_SAMPLECONVERSION_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+/*  The AVX2 kernels are compiled alongside the SSE2 ones, and only used if the CPU that
+    it's running on turns out to have AVX2.
+*/
+#if JUCE_SAMPLECONVERSION_USE_SSE2
+ #if JUCE_MSVC && _MSC_VER >= 1700
+  #define JUCE_SAMPLECONVERSION_USE_AVX2 1
+  #define JUCE_SAMPLECONVERSION_AVX2_FUNCTION
+  #define JUCE_SAMPLECONVERSION_FLATTEN
+  #include <immintrin.h>
+  #include <intrin.h>
+ #elif (defined (__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) \
+        || (! defined (__clang__) && defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+  #define JUCE_SAMPLECONVERSION_USE_AVX2 1
+  #define JUCE_SAMPLECONVERSION_AVX2_FUNCTION __attribute__ ((target ("avx2")))
+  #define JUCE_SAMPLECONVERSION_FLATTEN __attribute__ ((flatten))
+  #include <immintrin.h>
+  #include <cpuid.h>
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    /** How many frames are dealt with at a time. This keeps a tile of 64 channels of
+        doubles inside a typical L2 cache, and 2 channels of anything inside L1.
+    */
+    enum { framesPerTile = 256 };
+
+    template <int numBytes>
+    struct RawSample
+    {
+        char data [numBytes];
+    };
+
+    template <int bytesPerSample>
+    void interleaveTile (const void* const* sourceChannels, int numChannels, void* dest,
+                         int startFrame, int numFrames) noexcept
+    {
+        typedef RawSample<bytesPerSample> Sample;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            Sample* d = static_cast<Sample*> (dest) + (startFrame * numChannels + ch);
+            const Sample* s = static_cast<const Sample*> (sourceChannels[ch]);
+
+            if (s == nullptr)
+            {
+                Sample zero;
+                zerostruct (zero);
+
+                for (int i = 0; i < numFrames; ++i)
+                    d [i * numChannels] = zero;
+            }
+            else
+            {
+                s += startFrame;
+
+                for (int i = 0; i < numFrames; ++i)
+                    d [i * numChannels] = s[i];
+            }
+        }
+    }
+
+    template <int bytesPerSample>
+    void deinterleaveTile (const void* source, int numChannels, void* const* destChannels,
+                           int startFrame, int numFrames) noexcept
+    {
+        typedef RawSample<bytesPerSample> Sample;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            Sample* d = static_cast<Sample*> (destChannels[ch]);
+
+            if (d != nullptr)
+            {
+                const Sample* s = static_cast<const Sample*> (source) + (startFrame * numChannels + ch);
+                d += startFrame;
+
+                for (int i = 0; i < numFrames; ++i)
+                    d[i] = s [i * numChannels];
+            }
+        }
+    }
+
+    template <int bytesPerSample>
+    void interleaveTiled (const void* const* sourceChannels, int numChannels, void* dest, int numFrames) noexcept
+    {
+        for (int start = 0; start < numFrames; start += framesPerTile)
+            interleaveTile<bytesPerSample> (sourceChannels, numChannels, dest, start, jmin ((int) framesPerTile, numFrames - start));
+    }
+
+    template <int bytesPerSample>
+    void deinterleaveTiled (const void* source, int numChannels, void* const* destChannels, int numFrames) noexcept
+    {
+        for (int start = 0; start < numFrames; start += framesPerTile)
+            deinterleaveTile<bytesPerSample> (source, numChannels, destChannels, start, jmin ((int) framesPerTile, numFrames - start));
+    }
+
+    //==============================================================================
+    /** Vector versions of the most common layouts. Returns false if it can't do this one. */
+    bool interleaveWithVectors (const void* const* sourceChannels, int numChannels,
+                                void* dest, int bytesPerSample, int numFrames) noexcept
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (sourceChannels[ch] == nullptr)
+                return false;
+
+       #if JUCE_SAMPLECONVERSION_USE_SSE2
+        if (numChannels == 2 && bytesPerSample == 2)
+        {
+            const int16* const l = static_cast<const int16*> (sourceChannels[0]);
+            const int16* const r = static_cast<const int16*> (sourceChannels[1]);
+            int16* const d = static_cast<int16*> (dest);
+            int i = 0;
+
+            for (; i + 8 <= numFrames; i += 8)
+            {
+                const __m128i a = _mm_loadu_si128 ((const __m128i*) (l + i));
+                const __m128i b = _mm_loadu_si128 ((const __m128i*) (r + i));
+                _mm_storeu_si128 ((__m128i*) (d + 2 * i),     _mm_unpacklo_epi16 (a, b));
+                _mm_storeu_si128 ((__m128i*) (d + 2 * i + 8), _mm_unpackhi_epi16 (a, b));
+            }
+
+            for (; i < numFrames; ++i)
+            {
+                d [2 * i]     = l[i];
+                d [2 * i + 1] = r[i];
+            }
+
+            return true;
+        }
+
+        if (numChannels == 2 && bytesPerSample == 4)
+        {
+            const int32* const l = static_cast<const int32*> (sourceChannels[0]);
+            const int32* const r = static_cast<const int32*> (sourceChannels[1]);
+            int32* const d = static_cast<int32*> (dest);
+            int i = 0;
+
+            for (; i + 4 <= numFrames; i += 4)
+            {
+                const __m128i a = _mm_loadu_si128 ((const __m128i*) (l + i));
+                const __m128i b = _mm_loadu_si128 ((const __m128i*) (r + i));
+                _mm_storeu_si128 ((__m128i*) (d + 2 * i),     _mm_unpacklo_epi32 (a, b));
+                _mm_storeu_si128 ((__m128i*) (d + 2 * i + 4), _mm_unpackhi_epi32 (a, b));
+            }
+
+            for (; i < numFrames; ++i)
+            {
+                d [2 * i]     = l[i];
+                d [2 * i + 1] = r[i];
+            }
+
+            return true;
+        }
+
+        if (numChannels == 4 && bytesPerSample == 4)
+        {
+            const int32* const c0 = static_cast<const int32*> (sourceChannels[0]);
+            const int32* const c1 = static_cast<const int32*> (sourceChannels[1]);
+            const int32* const c2 = static_cast<const int32*> (sourceChannels[2]);
+            const int32* const c3 = static_cast<const int32*> (sourceChannels[3]);
+            int32* const d = static_cast<int32*> (dest);
+            int i = 0;
+
+            for (; i + 4 <= numFrames; i += 4)
+            {
+                // a 4x4 transpose: four samples from each channel become four frames
+                const __m128i a = _mm_loadu_si128 ((const __m128i*) (c0 + i));
+                const __m128i b = _mm_loadu_si128 ((const __m128i*) (c1 + i));
+                const __m128i c = _mm_loadu_si128 ((const __m128i*) (c2 + i));
+                const __m128i e = _mm_loadu_si128 ((const __m128i*) (c3 + i));
+
+                const __m128i ab01 = _mm_unpacklo_epi32 (a, b), ab23 = _mm_unpackhi_epi32 (a, b);
+                const __m128i ce01 = _mm_unpacklo_epi32 (c, e), ce23 = _mm_unpackhi_epi32 (c, e);
+
+                _mm_storeu_si128 ((__m128i*) (d + 4 * i),      _mm_unpacklo_epi64 (ab01, ce01));
+                _mm_storeu_si128 ((__m128i*) (d + 4 * i + 4),  _mm_unpackhi_epi64 (ab01, ce01));
+                _mm_storeu_si128 ((__m128i*) (d + 4 * i + 8),  _mm_unpacklo_epi64 (ab23, ce23));
+                _mm_storeu_si128 ((__m128i*) (d + 4 * i + 12), _mm_unpackhi_epi64 (ab23, ce23));
+            }
+
+            for (; i < numFrames; ++i)
+            {
+                d [4 * i]     = c0[i];
+                d [4 * i + 1] = c1[i];
+                d [4 * i + 2] = c2[i];
+                d [4 * i + 3] = c3[i];
+            }
+
+            return true;
+        }
+       #elif JUCE_SAMPLECONVERSION_USE_NEON
+        if (numChannels == 2 && bytesPerSample == 2)
+        {
+            const int16* const l = static_cast<const int16*> (sourceChannels[0]);
+            const int16* const r = static_cast<const int16*> (sourceChannels[1]);
+            int16* const d = static_cast<int16*> (dest);
+            int i = 0;
+
+            for (; i + 8 <= numFrames; i += 8)
+            {
+                int16x8x2_t frames;
+                frames.val[0] = vld1q_s16 (l + i);
+                frames.val[1] = vld1q_s16 (r + i);
+                vst2q_s16 (d + 2 * i, frames);
+            }
+
+            for (; i < numFrames; ++i)
+            {
+                d [2 * i]     = l[i];
+                d [2 * i + 1] = r[i];
+            }
+
+            return true;
+        }
+
+        if ((numChannels == 2 || numChannels == 4) && bytesPerSample == 4)
+        {
+            int32* const d = static_cast<int32*> (dest);
+            int i = 0;
+
+            if (numChannels == 2)
+            {
+                for (; i + 4 <= numFrames; i += 4)
+                {
+                    int32x4x2_t frames;
+                    frames.val[0] = vld1q_s32 (static_cast<const int32*> (sourceChannels[0]) + i);
+                    frames.val[1] = vld1q_s32 (static_cast<const int32*> (sourceChannels[1]) + i);
+                    vst2q_s32 (d + 2 * i, frames);
+                }
+            }
+            else
+            {
+                for (; i + 4 <= numFrames; i += 4)
+                {
+                    int32x4x4_t frames;
+                    frames.val[0] = vld1q_s32 (static_cast<const int32*> (sourceChannels[0]) + i);
+                    frames.val[1] = vld1q_s32 (static_cast<const int32*> (sourceChannels[1]) + i);
+                    frames.val[2] = vld1q_s32 (static_cast<const int32*> (sourceChannels[2]) + i);
+                    frames.val[3] = vld1q_s32 (static_cast<const int32*> (sourceChannels[3]) + i);
+                    vst4q_s32 (d + 4 * i, frames);
+                }
+            }
+
+            for (; i < numFrames; ++i)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    d [numChannels * i + ch] = static_cast<const int32*> (sourceChannels[ch])[i];
+
+            return true;
+        }
+       #else
+        (void) dest; (void) bytesPerSample; (void) numFrames;
+       #endif
+
+        return false;
+    }
+
+    //==============================================================================
+    template <class DestSampleType, class DestEndianness>
+    void convertChannel (const float* source, void* dest, int numSamples)
+    {
+        AudioData::Pointer <DestSampleType, DestEndianness, AudioData::NonInterleaved, AudioData::NonConst> d (dest);
+        d.convertSamples (AudioData::Pointer <AudioData::Float32, AudioData::NativeEndian, AudioData::NonInterleaved, AudioData::Const> (source), numSamples);
+    }
+
+    // AudioData has no 64-bit float type, so doubles are dealt with by hand
+    template <bool bigEndian>
+    void convertChannelToFloat64 (const float* source, void* dest, int numSamples)
+    {
+        uint64* const d = static_cast<uint64*> (dest);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            union { uint64 asInt; double asDouble; } n;
+            n.asDouble = (double) source[i];
+            d[i] = bigEndian ? ByteOrder::swapIfLittleEndian (n.asInt) : ByteOrder::swapIfBigEndian (n.asInt);
+        }
+    }
+
+    template <class DestType> struct DestSampleFormat;
+    template <> struct DestSampleFormat<float>  { typedef AudioData::Float32 Type; };
+    template <> struct DestSampleFormat<int>    { typedef AudioData::Int32 Type; };
+
+    template <class SourceSampleType, class SourceEndianness, class DestType>
+    void convertChannelFromInterleaved (const void* source, int numSourceChannels, DestType* dest, int numSamples)
+    {
+        AudioData::Pointer <typename DestSampleFormat<DestType>::Type, AudioData::NativeEndian, AudioData::NonInterleaved, AudioData::NonConst> d (dest);
+        d.convertSamples (AudioData::Pointer <SourceSampleType, SourceEndianness, AudioData::Interleaved, AudioData::Const> (source, numSourceChannels), numSamples);
+    }
+
+    inline void storeFloat64 (double value, float* dest) noexcept     { *dest = (float) value; }
+    inline void storeFloat64 (double value, int* dest) noexcept       { *dest = roundToInt (jlimit (-1.0, 1.0, value) * (double) 0x7fffffff); }
+
+    template <bool bigEndian, class DestType>
+    void convertChannelFromFloat64 (const void* source, int numSourceChannels, DestType* dest, int numSamples)
+    {
+        const char* s = static_cast<const char*> (source);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            union { uint64 asInt; double asDouble; } n;
+            n.asInt = bigEndian ? ByteOrder::bigEndianInt64 (s) : ByteOrder::littleEndianInt64 (s);
+            storeFloat64 (n.asDouble, dest + i);
+            s += numSourceChannels * (int) sizeof (double);
+        }
+    }
+
+    typedef void (*ChannelConverterFunction) (const float*, void*, int);
+
+    ChannelConverterFunction getChannelConverter (SampleConversion::SampleFormat format, bool bigEndian)
+    {
+        using namespace SampleConversion;
+
+        switch (format)
+        {
+            case int8Format:      return convertChannel<AudioData::Int8,  AudioData::LittleEndian>;
+            case uint8Format:     return convertChannel<AudioData::UInt8, AudioData::LittleEndian>;
+            case int16Format:     return bigEndian ? convertChannel<AudioData::Int16, AudioData::BigEndian>   : convertChannel<AudioData::Int16, AudioData::LittleEndian>;
+            case int24Format:     return bigEndian ? convertChannel<AudioData::Int24, AudioData::BigEndian>   : convertChannel<AudioData::Int24, AudioData::LittleEndian>;
+            case int32Format:     return bigEndian ? convertChannel<AudioData::Int32, AudioData::BigEndian>   : convertChannel<AudioData::Int32, AudioData::LittleEndian>;
+            case float32Format:   return bigEndian ? convertChannel<AudioData::Float32, AudioData::BigEndian> : convertChannel<AudioData::Float32, AudioData::LittleEndian>;
+            case float64Format:   return bigEndian ? convertChannelToFloat64<true> : convertChannelToFloat64<false>;
+            default:        jassertfalse; return nullptr;
+        }
+    }
+
+    template <class DestType>
+    struct ChannelReader
+    {
+        typedef void (*Function) (const void*, int, DestType*, int);
+
+        static Function get (SampleConversion::SampleFormat format, bool bigEndian)
+        {
+            using namespace SampleConversion;
+
+            switch (format)
+            {
+                case int8Format:      return convertChannelFromInterleaved<AudioData::Int8,  AudioData::LittleEndian, DestType>;
+                case uint8Format:     return convertChannelFromInterleaved<AudioData::UInt8, AudioData::LittleEndian, DestType>;
+                case int16Format:     return bigEndian ? convertChannelFromInterleaved<AudioData::Int16, AudioData::BigEndian, DestType>   : convertChannelFromInterleaved<AudioData::Int16, AudioData::LittleEndian, DestType>;
+                case int24Format:     return bigEndian ? convertChannelFromInterleaved<AudioData::Int24, AudioData::BigEndian, DestType>   : convertChannelFromInterleaved<AudioData::Int24, AudioData::LittleEndian, DestType>;
+                case int32Format:     return bigEndian ? convertChannelFromInterleaved<AudioData::Int32, AudioData::BigEndian, DestType>   : convertChannelFromInterleaved<AudioData::Int32, AudioData::LittleEndian, DestType>;
+                case float32Format:   return bigEndian ? convertChannelFromInterleaved<AudioData::Float32, AudioData::BigEndian, DestType> : convertChannelFromInterleaved<AudioData::Float32, AudioData::LittleEndian, DestType>;
+                case float64Format:   return bigEndian ? convertChannelFromFloat64<true, DestType> : convertChannelFromFloat64<false, DestType>;
+                default:        jassertfalse; return nullptr;
+            }
+        }
+
+        static void convert (const void* source, int numSourceChannels,
+                             SampleConversion::SampleFormat sourceFormat, bool sourceIsBigEndian,
+                             DestType* const* destChannels, int numDestChannels, int numFrames)
+        {
+            const Function convertChannel = get (sourceFormat, sourceIsBigEndian);
+            const int bytesPerSample = SampleConversion::getBytesPerSample (sourceFormat);
+            const int frameSize = numSourceChannels * bytesPerSample;
+            numDestChannels = jmin (numDestChannels, numSourceChannels);
+
+            if (convertChannel == nullptr || numDestChannels <= 0)
+                return;
+
+            // a tile at a time, so that each one is read from memory once however many channels there are
+            for (int start = 0; start < numFrames; start += framesPerTile)
+            {
+                const int numInTile = jmin ((int) framesPerTile, numFrames - start);
+
+                for (int ch = 0; ch < numDestChannels; ++ch)
+                    if (destChannels[ch] != nullptr)
+                        convertChannel (addBytesToPointer (source, start * frameSize + ch * bytesPerSample),
+                                        numSourceChannels, destChannels[ch] + start, numInTile);
+            }
+        }
+    };
+
+    //==============================================================================
+    /*  The float to integer conversion kernels.
+
+        Each one scales, dithers, clips, rounds, byte-swaps and interleaves in a single
+        pass over the source channels. The kernel body is shared, and the VectorOps
+        classes below supply the instruction-set specific parts of it.
+    */
+    template <int numBytes> struct IntFormat;
+
+    template <> struct IntFormat<2>
+    {
+        static float scale() noexcept       { return 32768.0f; }
+        static float lowest() noexcept      { return -32768.0f; }
+        static float highest() noexcept     { return 32767.0f; }
+    };
+
+    template <> struct IntFormat<3>
+    {
+        static float scale() noexcept       { return 8388608.0f; }
+        static float lowest() noexcept      { return -8388608.0f; }
+        static float highest() noexcept     { return 8388607.0f; }
+    };
+
+    template <> struct IntFormat<4>
+    {
+        static float scale() noexcept       { return 2147483648.0f; }
+        static float lowest() noexcept      { return -2147483648.0f; }
+        static float highest() noexcept     { return 2147483520.0f; }     // the largest float below 2^31
+    };
+
+    template <int numBytes, bool bigEndian>
+    forcedinline void writeSample (char* dest, int32 value) noexcept
+    {
+        for (int i = 0; i < numBytes; ++i)
+            dest [bigEndian ? numBytes - 1 - i : i] = (char) (value >> (8 * i));
+    }
+
+    /*  Dither noise comes from a xorshift generator in each vector lane. The two halves
+        of each random word are subtracted to give noise with a triangular distribution
+        that spans +/- 1 LSB.
+    */
+    forcedinline uint32 nextRandom (uint32& state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    //==============================================================================
+    struct ScalarOps
+    {
+        enum { numLanes = 1 };
+
+        struct Noise
+        {
+            Noise (uint32* stored_) noexcept  : stored (stored_), state (stored_ != nullptr ? stored_[0] : 0) {}
+            ~Noise() noexcept                 { if (stored != nullptr) stored[0] = state; }
+
+            uint32* stored;
+            uint32 state;
+        };
+
+        template <int numBytes, bool dither>
+        static forcedinline int32 convert (const float* source, Noise& noise) noexcept
+        {
+            typedef IntFormat<numBytes> Format;
+            float v = source[0] * Format::scale();
+
+            if (dither)
+            {
+                const uint32 r = nextRandom (noise.state);
+                v += (float) ((int) (r >> 16) - (int) (r & 0xffff)) * (1.0f / 65536.0f);
+            }
+
+            return (int32) roundToInt (jlimit (Format::lowest(), Format::highest(), v));
+        }
+
+        template <int numBytes, bool dither>
+        static forcedinline void convertToLanes (const float* source, Noise& noise, int32* lanes) noexcept
+        {
+            lanes[0] = convert<numBytes, dither> (source, noise);
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertMono (const float* source, Noise& noise, char* dest) noexcept
+        {
+            writeSample<numBytes, bigEndian> (dest, convert<numBytes, dither> (source, noise));
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertStereo (const float* left, const float* right, Noise& noise, char* dest) noexcept
+        {
+            writeSample<numBytes, bigEndian> (dest, convert<numBytes, dither> (left, noise));
+            writeSample<numBytes, bigEndian> (dest + numBytes, convert<numBytes, dither> (right, noise));
+        }
+
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeFourChannels (const int32* const* channels, char* dest, int frameSize) noexcept
+        {
+            for (int i = 0; i < 4; ++i)
+                for (int ch = 0; ch < 4; ++ch)
+                    writeSample<numBytes, bigEndian> (dest + i * frameSize + ch * numBytes, channels[ch][i]);
+        }
+    };
+
+   #if JUCE_SAMPLECONVERSION_USE_SSE2
+    //==============================================================================
+    struct SSE2Ops
+    {
+        enum { numLanes = 4 };
+
+        struct Noise
+        {
+            Noise (uint32* stored_) noexcept
+                : stored (stored_),
+                  state (stored_ != nullptr ? _mm_loadu_si128 ((const __m128i*) stored_) : _mm_setzero_si128())
+            {}
+
+            ~Noise() noexcept
+            {
+                if (stored != nullptr)
+                    _mm_storeu_si128 ((__m128i*) stored, state);
+            }
+
+            uint32* stored;
+            __m128i state;
+        };
+
+        static forcedinline __m128 triangularNoise (__m128i& s) noexcept
+        {
+            s = _mm_xor_si128 (s, _mm_slli_epi32 (s, 13));
+            s = _mm_xor_si128 (s, _mm_srli_epi32 (s, 17));
+            s = _mm_xor_si128 (s, _mm_slli_epi32 (s, 5));
+
+            const __m128i difference = _mm_sub_epi32 (_mm_srli_epi32 (s, 16), _mm_and_si128 (s, _mm_set1_epi32 (0xffff)));
+            return _mm_mul_ps (_mm_cvtepi32_ps (difference), _mm_set1_ps (1.0f / 65536.0f));
+        }
+
+        template <int numBytes, bool dither>
+        static forcedinline __m128i convert (const float* source, Noise& noise) noexcept
+        {
+            typedef IntFormat<numBytes> Format;
+            __m128 v = _mm_mul_ps (_mm_loadu_ps (source), _mm_set1_ps (Format::scale()));
+
+            if (dither)
+                v = _mm_add_ps (v, triangularNoise (noise.state));
+
+            v = _mm_min_ps (_mm_max_ps (v, _mm_set1_ps (Format::lowest())), _mm_set1_ps (Format::highest()));
+            return _mm_cvtps_epi32 (v);     // rounds to nearest, unless someone has changed the MXCSR mode
+        }
+
+        static forcedinline __m128i swap16 (__m128i v) noexcept    { return _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8)); }
+        static forcedinline __m128i swap32 (__m128i v) noexcept    { v = swap16 (v); return _mm_or_si128 (_mm_slli_epi32 (v, 16), _mm_srli_epi32 (v, 16)); }
+
+        /** Writes the low three bytes of each of four samples, which is 12 bytes in all. */
+        template <bool bigEndian>
+        static forcedinline void store24 (char* dest, __m128i samples) noexcept
+        {
+            // (swapping all four bytes puts the top one at the bottom, where it's shifted out)
+            if (bigEndian)
+                samples = _mm_srli_epi32 (swap32 (samples), 8);
+
+            // close the gap between the two samples in each 64-bit half, then the one between the halves
+            const __m128i masked = _mm_and_si128 (samples, _mm_set1_epi32 (0xffffff));
+            const __m128i pairs = _mm_or_si128 (_mm_and_si128 (masked, _mm_set_epi32 (0, -1, 0, -1)),
+                                                _mm_slli_epi64 (_mm_srli_epi64 (masked, 32), 24));
+            const __m128i packed = _mm_or_si128 (_mm_move_epi64 (pairs), _mm_slli_si128 (_mm_unpackhi_epi64 (pairs, pairs), 6));
+
+            _mm_storel_epi64 ((__m128i*) dest, packed);
+            const int32 lastFour = _mm_cvtsi128_si32 (_mm_srli_si128 (packed, 8));
+            memcpy (dest + 8, &lastFour, sizeof (lastFour));
+        }
+
+        // these write four samples in a row, which can be four mono frames or one frame of
+        // four channels, or four stereo frames
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeMono (char* dest, __m128i samples) noexcept
+        {
+            if (numBytes == 2)
+            {
+                const __m128i packed = _mm_packs_epi32 (samples, samples);
+                _mm_storel_epi64 ((__m128i*) dest, bigEndian ? swap16 (packed) : packed);
+            }
+            else if (numBytes == 3)
+            {
+                store24<bigEndian> (dest, samples);
+            }
+            else
+            {
+                _mm_storeu_si128 ((__m128i*) dest, bigEndian ? swap32 (samples) : samples);
+            }
+        }
+
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeStereo (char* dest, __m128i left, __m128i right) noexcept
+        {
+            if (numBytes == 2)
+            {
+                const __m128i frames = _mm_unpacklo_epi16 (_mm_packs_epi32 (left, left), _mm_packs_epi32 (right, right));
+                _mm_storeu_si128 ((__m128i*) dest, bigEndian ? swap16 (frames) : frames);
+            }
+            else
+            {
+                storeMono<numBytes, bigEndian> (dest,                _mm_unpacklo_epi32 (left, right));
+                storeMono<numBytes, bigEndian> (dest + 4 * numBytes, _mm_unpackhi_epi32 (left, right));
+            }
+        }
+
+        /** Transposes four samples from each of four channels into four frames. */
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeFourChannels (const int32* const* channels, char* dest, int frameSize) noexcept
+        {
+            const __m128i a = _mm_loadu_si128 ((const __m128i*) channels[0]);
+            const __m128i b = _mm_loadu_si128 ((const __m128i*) channels[1]);
+            const __m128i c = _mm_loadu_si128 ((const __m128i*) channels[2]);
+            const __m128i e = _mm_loadu_si128 ((const __m128i*) channels[3]);
+
+            const __m128i ab01 = _mm_unpacklo_epi32 (a, b), ab23 = _mm_unpackhi_epi32 (a, b);
+            const __m128i ce01 = _mm_unpacklo_epi32 (c, e), ce23 = _mm_unpackhi_epi32 (c, e);
+
+            storeMono<numBytes, bigEndian> (dest,                 _mm_unpacklo_epi64 (ab01, ce01));
+            storeMono<numBytes, bigEndian> (dest + frameSize,     _mm_unpackhi_epi64 (ab01, ce01));
+            storeMono<numBytes, bigEndian> (dest + 2 * frameSize, _mm_unpacklo_epi64 (ab23, ce23));
+            storeMono<numBytes, bigEndian> (dest + 3 * frameSize, _mm_unpackhi_epi64 (ab23, ce23));
+        }
+
+        template <int numBytes, bool dither>
+        static forcedinline void convertToLanes (const float* source, Noise& noise, int32* lanes) noexcept
+        {
+            _mm_storeu_si128 ((__m128i*) lanes, convert<numBytes, dither> (source, noise));
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertMono (const float* source, Noise& noise, char* dest) noexcept
+        {
+            storeMono<numBytes, bigEndian> (dest, convert<numBytes, dither> (source, noise));
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertStereo (const float* left, const float* right, Noise& noise, char* dest) noexcept
+        {
+            const __m128i l = convert<numBytes, dither> (left, noise);
+            storeStereo<numBytes, bigEndian> (dest, l, convert<numBytes, dither> (right, noise));
+        }
+    };
+   #endif
+
+   #if JUCE_SAMPLECONVERSION_USE_AVX2
+    //==============================================================================
+    /*  These can't be force-inlined, as they're compiled for AVX2 while the shared kernel
+        isn't: the kernels that use them are flattened into AVX2 functions instead.
+    */
+    struct AVX2Ops
+    {
+        enum { numLanes = 8 };
+
+        struct Noise
+        {
+            JUCE_SAMPLECONVERSION_AVX2_FUNCTION Noise (uint32* stored_) noexcept
+                : stored (stored_),
+                  state (stored_ != nullptr ? _mm256_loadu_si256 ((const __m256i*) stored_) : _mm256_setzero_si256())
+            {}
+
+            JUCE_SAMPLECONVERSION_AVX2_FUNCTION ~Noise() noexcept
+            {
+                if (stored != nullptr)
+                    _mm256_storeu_si256 ((__m256i*) stored, state);
+            }
+
+            uint32* stored;
+            __m256i state;
+        };
+
+        template <int numBytes, bool dither>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION inline void convert (const float* source, Noise& noise, __m128i& lo, __m128i& hi) noexcept
+        {
+            typedef IntFormat<numBytes> Format;
+            __m256 v = _mm256_mul_ps (_mm256_loadu_ps (source), _mm256_set1_ps (Format::scale()));
+
+            if (dither)
+            {
+                __m256i& s = noise.state;
+                s = _mm256_xor_si256 (s, _mm256_slli_epi32 (s, 13));
+                s = _mm256_xor_si256 (s, _mm256_srli_epi32 (s, 17));
+                s = _mm256_xor_si256 (s, _mm256_slli_epi32 (s, 5));
+
+                const __m256i difference = _mm256_sub_epi32 (_mm256_srli_epi32 (s, 16), _mm256_and_si256 (s, _mm256_set1_epi32 (0xffff)));
+                v = _mm256_add_ps (v, _mm256_mul_ps (_mm256_cvtepi32_ps (difference), _mm256_set1_ps (1.0f / 65536.0f)));
+            }
+
+            v = _mm256_min_ps (_mm256_max_ps (v, _mm256_set1_ps (Format::lowest())), _mm256_set1_ps (Format::highest()));
+
+            const __m256i samples = _mm256_cvtps_epi32 (v);
+            lo = _mm256_castsi256_si128 (samples);
+            hi = _mm256_extracti128_si256 (samples, 1);
+        }
+
+        template <int numBytes, bool dither>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION inline void convertToLanes (const float* source, Noise& noise, int32* lanes) noexcept
+        {
+            __m128i lo, hi;
+            convert<numBytes, dither> (source, noise, lo, hi);
+            _mm_storeu_si128 ((__m128i*) lanes, lo);
+            _mm_storeu_si128 ((__m128i*) (lanes + 4), hi);
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION inline void convertMono (const float* source, Noise& noise, char* dest) noexcept
+        {
+            __m128i lo, hi;
+            convert<numBytes, dither> (source, noise, lo, hi);
+            SSE2Ops::storeMono<numBytes, bigEndian> (dest, lo);
+            SSE2Ops::storeMono<numBytes, bigEndian> (dest + 4 * numBytes, hi);
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION inline void convertStereo (const float* left, const float* right, Noise& noise, char* dest) noexcept
+        {
+            __m128i leftLo, leftHi, rightLo, rightHi;
+            convert<numBytes, dither> (left, noise, leftLo, leftHi);
+            convert<numBytes, dither> (right, noise, rightLo, rightHi);
+            SSE2Ops::storeStereo<numBytes, bigEndian> (dest, leftLo, rightLo);
+            SSE2Ops::storeStereo<numBytes, bigEndian> (dest + 8 * numBytes, leftHi, rightHi);
+        }
+
+        template <int numBytes, bool bigEndian>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION inline void storeFourChannels (const int32* const* channels, char* dest, int frameSize) noexcept
+        {
+            SSE2Ops::storeFourChannels<numBytes, bigEndian> (channels, dest, frameSize);
+        }
+    };
+   #endif
+
+   #if JUCE_SAMPLECONVERSION_USE_NEON
+    //==============================================================================
+    struct NeonOps
+    {
+        enum { numLanes = 4 };
+
+        struct Noise
+        {
+            Noise (uint32* stored_) noexcept
+                : stored (stored_),
+                  state (stored_ != nullptr ? vld1q_u32 (stored_) : vdupq_n_u32 (0))
+            {}
+
+            ~Noise() noexcept
+            {
+                if (stored != nullptr)
+                    vst1q_u32 (stored, state);
+            }
+
+            uint32* stored;
+            uint32x4_t state;
+        };
+
+        template <int numBytes, bool dither>
+        static forcedinline int32x4_t convert (const float* source, Noise& noise) noexcept
+        {
+            typedef IntFormat<numBytes> Format;
+            float32x4_t v = vmulq_n_f32 (vld1q_f32 (source), Format::scale());
+
+            if (dither)
+            {
+                uint32x4_t& s = noise.state;
+                s = veorq_u32 (s, vshlq_n_u32 (s, 13));
+                s = veorq_u32 (s, vshrq_n_u32 (s, 17));
+                s = veorq_u32 (s, vshlq_n_u32 (s, 5));
+
+                const int32x4_t difference = vsubq_s32 (vreinterpretq_s32_u32 (vshrq_n_u32 (s, 16)),
+                                                        vreinterpretq_s32_u32 (vandq_u32 (s, vdupq_n_u32 (0xffff))));
+                v = vmlaq_n_f32 (v, vcvtq_f32_s32 (difference), 1.0f / 65536.0f);
+            }
+
+            v = vminq_f32 (vmaxq_f32 (v, vdupq_n_f32 (Format::lowest())), vdupq_n_f32 (Format::highest()));
+
+           #if defined (__aarch64__) || defined (_M_ARM64)
+            return vcvtnq_s32_f32 (v);
+           #else
+            // ARMv7 can only truncate, so this rounds halves away from zero
+            const uint32x4_t signBit = vandq_u32 (vreinterpretq_u32_f32 (v), vdupq_n_u32 (0x80000000));
+            const float32x4_t half = vreinterpretq_f32_u32 (vorrq_u32 (signBit, vreinterpretq_u32_f32 (vdupq_n_f32 (0.5f))));
+            return vcvtq_s32_f32 (vaddq_f32 (v, half));
+           #endif
+        }
+
+        static forcedinline int16x4_t swap16 (int16x4_t v) noexcept    { return vreinterpret_s16_s8 (vrev16_s8 (vreinterpret_s8_s16 (v))); }
+        static forcedinline int32x4_t swap32 (int32x4_t v) noexcept    { return vreinterpretq_s32_s8 (vrev32q_s8 (vreinterpretq_s8_s32 (v))); }
+
+        template <int numBytes, bool dither>
+        static forcedinline void convertToLanes (const float* source, Noise& noise, int32* lanes) noexcept
+        {
+            vst1q_s32 (lanes, convert<numBytes, dither> (source, noise));
+        }
+
+        /** Writes the low three bytes of each of four samples, which is 12 bytes in all. */
+        template <bool bigEndian>
+        static forcedinline void store24 (char* dest, int32x4_t samples) noexcept
+        {
+            uint32x4_t s = vreinterpretq_u32_s32 (bigEndian ? swap32 (samples) : samples);
+
+            // (swapping all four bytes puts the top one at the bottom, where it's shifted out)
+            if (bigEndian)
+                s = vshrq_n_u32 (s, 8);
+
+            // close the gap between the two samples in each 64-bit half, and write out six bytes of each
+            const uint64x2_t masked = vreinterpretq_u64_u32 (vandq_u32 (s, vdupq_n_u32 (0xffffff)));
+            const uint64x2_t pairs = vorrq_u64 (vandq_u64 (masked, vdupq_n_u64 (0xffffffffu)),
+                                                vshlq_n_u64 (vshrq_n_u64 (masked, 32), 24));
+            uint8 bytes [16];
+            vst1q_u8 (bytes, vreinterpretq_u8_u64 (pairs));
+            memcpy (dest, bytes, 6);
+            memcpy (dest + 6, bytes + 8, 6);
+        }
+
+        // this writes four samples in a row, which can be four mono frames or one frame of four channels
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeMono (char* dest, int32x4_t samples) noexcept
+        {
+            if (numBytes == 2)
+            {
+                const int16x4_t narrowed = vqmovn_s32 (samples);
+                vst1_s16 ((int16*) dest, bigEndian ? swap16 (narrowed) : narrowed);
+            }
+            else if (numBytes == 3)
+            {
+                store24<bigEndian> (dest, samples);
+            }
+            else
+            {
+                vst1q_s32 ((int32*) dest, bigEndian ? swap32 (samples) : samples);
+            }
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertMono (const float* source, Noise& noise, char* dest) noexcept
+        {
+            storeMono<numBytes, bigEndian> (dest, convert<numBytes, dither> (source, noise));
+        }
+
+        template <int numBytes, bool bigEndian, bool dither>
+        static forcedinline void convertStereo (const float* left, const float* right, Noise& noise, char* dest) noexcept
+        {
+            const int32x4_t l = convert<numBytes, dither> (left, noise);
+            const int32x4_t r = convert<numBytes, dither> (right, noise);
+
+            if (numBytes == 2)
+            {
+                int16x4x2_t frames;
+                frames.val[0] = vqmovn_s32 (l);
+                frames.val[1] = vqmovn_s32 (r);
+
+                if (bigEndian)
+                {
+                    frames.val[0] = swap16 (frames.val[0]);
+                    frames.val[1] = swap16 (frames.val[1]);
+                }
+
+                vst2_s16 ((int16*) dest, frames);
+            }
+            else if (numBytes == 3)
+            {
+                const int32x4x2_t frames = vzipq_s32 (l, r);
+                store24<bigEndian> (dest,      frames.val[0]);
+                store24<bigEndian> (dest + 12, frames.val[1]);
+            }
+            else
+            {
+                int32x4x2_t frames;
+                frames.val[0] = bigEndian ? swap32 (l) : l;
+                frames.val[1] = bigEndian ? swap32 (r) : r;
+                vst2q_s32 ((int32*) dest, frames);
+            }
+        }
+
+        /** Transposes four samples from each of four channels into four frames. */
+        template <int numBytes, bool bigEndian>
+        static forcedinline void storeFourChannels (const int32* const* channels, char* dest, int frameSize) noexcept
+        {
+            const int32x4x2_t ab = vtrnq_s32 (vld1q_s32 (channels[0]), vld1q_s32 (channels[1]));
+            const int32x4x2_t ce = vtrnq_s32 (vld1q_s32 (channels[2]), vld1q_s32 (channels[3]));
+
+            storeMono<numBytes, bigEndian> (dest,                 vcombine_s32 (vget_low_s32 (ab.val[0]),  vget_low_s32 (ce.val[0])));
+            storeMono<numBytes, bigEndian> (dest + frameSize,     vcombine_s32 (vget_low_s32 (ab.val[1]),  vget_low_s32 (ce.val[1])));
+            storeMono<numBytes, bigEndian> (dest + 2 * frameSize, vcombine_s32 (vget_high_s32 (ab.val[0]), vget_high_s32 (ce.val[0])));
+            storeMono<numBytes, bigEndian> (dest + 3 * frameSize, vcombine_s32 (vget_high_s32 (ab.val[1]), vget_high_s32 (ce.val[1])));
+        }
+    };
+   #endif
+
+    //==============================================================================
+    template <class VectorOps, int numBytes, bool bigEndian, bool dither>
+    void convertToIntegers (const float* const* sourceChannels, int numChannels, void* dest, int numFrames, uint32* ditherState)
+    {
+        typename VectorOps::Noise noise (ditherState);
+
+        const int numLanes = (int) VectorOps::numLanes;
+        const int frameSize = numChannels * numBytes;
+        const int numWhole = numFrames - numFrames % numLanes;
+        char* const d = static_cast<char*> (dest);
+        int32 lanes [VectorOps::numLanes];
+
+        if (numChannels <= 2
+             && sourceChannels[0] != nullptr && (numChannels == 1 || sourceChannels[1] != nullptr))
+        {
+            // mono and stereo go straight from vector registers into the file
+            if (numChannels == 1)
+            {
+                for (int i = 0; i < numWhole; i += numLanes)
+                    VectorOps::template convertMono<numBytes, bigEndian, dither> (sourceChannels[0] + i, noise, d + i * frameSize);
+            }
+            else
+            {
+                for (int i = 0; i < numWhole; i += numLanes)
+                    VectorOps::template convertStereo<numBytes, bigEndian, dither> (sourceChannels[0] + i, sourceChannels[1] + i,
+                                                                                   noise, d + i * frameSize);
+            }
+        }
+        else
+        {
+            // everything else is converted a tile of four channels at a time, which is then
+            // transposed into the frames four by four. Any channels left over are scattered.
+            int32 tile [4][framesPerTile];
+            const int32* tileChannels [4];
+
+            for (int start = 0; start < numWhole; start += framesPerTile)
+            {
+                const int numInTile = jmin ((int) framesPerTile, numWhole - start);
+
+                for (int firstChannel = 0; firstChannel < numChannels; firstChannel += 4)
+                {
+                    const int numInGroup = jmin (4, numChannels - firstChannel);
+                    char* const groupDest = d + start * frameSize + firstChannel * numBytes;
+
+                    for (int ch = 0; ch < numInGroup; ++ch)
+                    {
+                        const float* const source = sourceChannels [firstChannel + ch];
+
+                        if (source != nullptr)
+                            for (int i = 0; i < numInTile; i += numLanes)
+                                VectorOps::template convertToLanes<numBytes, dither> (source + start + i, noise, tile[ch] + i);
+                        else
+                            zeromem (tile[ch], sizeof (int32) * (size_t) numInTile);
+                    }
+
+                    int i = 0;
+
+                    if (numInGroup == 4)
+                    {
+                        for (; i + 4 <= numInTile; i += 4)
+                        {
+                            for (int ch = 0; ch < 4; ++ch)
+                                tileChannels[ch] = tile[ch] + i;
+
+                            VectorOps::template storeFourChannels<numBytes, bigEndian> (tileChannels, groupDest + i * frameSize, frameSize);
+                        }
+                    }
+
+                    for (; i < numInTile; ++i)
+                        for (int ch = 0; ch < numInGroup; ++ch)
+                            writeSample<numBytes, bigEndian> (groupDest + i * frameSize + ch * numBytes, tile[ch][i]);
+                }
+            }
+        }
+
+        if (numWhole < numFrames)
+        {
+            // the last few frames go through a zero-padded copy, so that they get the same treatment
+            const int numLeft = numFrames - numWhole;
+            float padded [VectorOps::numLanes] = { 0 };
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (sourceChannels[ch] != nullptr)
+                {
+                    memcpy (padded, sourceChannels[ch] + numWhole, sizeof (float) * (size_t) numLeft);
+                    VectorOps::template convertToLanes<numBytes, dither> (padded, noise, lanes);
+                }
+                else
+                {
+                    zeromem (lanes, sizeof (lanes));
+                }
+
+                for (int j = 0; j < numLeft; ++j)
+                    writeSample<numBytes, bigEndian> (d + (numWhole + j) * frameSize + ch * numBytes, lanes[j]);
+            }
+        }
+    }
+
+    typedef void (*ConversionKernel) (const float* const*, int, void*, int, uint32*);
+
+    template <class VectorOps>
+    struct KernelSet
+    {
+        template <int numBytes, bool bigEndian, bool dither>
+        static void convert (const float* const* source, int numChannels, void* dest, int numFrames, uint32* ditherState)
+        {
+            convertToIntegers<VectorOps, numBytes, bigEndian, dither> (source, numChannels, dest, numFrames, ditherState);
+        }
+    };
+
+   #if JUCE_SAMPLECONVERSION_USE_AVX2
+    template <>
+    struct KernelSet<AVX2Ops>
+    {
+        template <int numBytes, bool bigEndian, bool dither>
+        static JUCE_SAMPLECONVERSION_AVX2_FUNCTION JUCE_SAMPLECONVERSION_FLATTEN
+        void convert (const float* const* source, int numChannels, void* dest, int numFrames, uint32* ditherState)
+        {
+            convertToIntegers<AVX2Ops, numBytes, bigEndian, dither> (source, numChannels, dest, numFrames, ditherState);
+        }
+    };
+   #endif
+
+    template <class VectorOps, int numBytes>
+    ConversionKernel getKernel (bool bigEndian, bool dither) noexcept
+    {
+        typedef KernelSet<VectorOps> Set;
+
+        if (bigEndian)
+            return dither ? Set::template convert<numBytes, true, true>  : Set::template convert<numBytes, true, false>;
+
+        return dither ? Set::template convert<numBytes, false, true> : Set::template convert<numBytes, false, false>;
+    }
+
+    template <class VectorOps>
+    ConversionKernel getKernel (int numBytes, bool bigEndian, bool dither) noexcept
+    {
+        switch (numBytes)
+        {
+            case 2:     return getKernel<VectorOps, 2> (bigEndian, dither);
+            case 3:     return getKernel<VectorOps, 3> (bigEndian, dither);
+            case 4:     return getKernel<VectorOps, 4> (bigEndian, dither);
+            default:    jassertfalse; return nullptr;
+        }
+    }
+
+    //==============================================================================
+    enum InstructionSet
+    {
+        scalarInstructions,
+        sse2Instructions,
+        avx2Instructions,
+        neonInstructions
+    };
+
+   #if JUCE_SAMPLECONVERSION_USE_AVX2
+    bool canUseAVX2() noexcept
+    {
+        int info[4] = { 0 };
+
+       #if JUCE_MSVC
+        __cpuid (info, 0);
+        const int maxLeaf = info[0];
+        __cpuid (info, 1);
+       #else
+        unsigned int maxLeaf = __get_cpuid_max (0, nullptr);
+        __cpuid (1, info[0], info[1], info[2], info[3]);
+       #endif
+
+        // the OS has to be saving the YMM registers as well as the CPU having them
+        const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+
+        if (maxLeaf < 7 || (info[2] & osxsaveAndAvx) != osxsaveAndAvx)
+            return false;
+
+       #if JUCE_MSVC
+        if ((_xgetbv (0) & 6) != 6)
+            return false;
+
+        __cpuidex (info, 7, 0);
+       #else
+        unsigned int xcr0Low, xcr0High;
+        __asm__ ("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+
+        if ((xcr0Low & 6) != 6)
+            return false;
+
+        __cpuid_count (7, 0, info[0], info[1], info[2], info[3]);
+       #endif
+
+        return (info[1] & (1 << 5)) != 0;
+    }
+   #endif
+
+    InstructionSet findInstructionSet() noexcept
+    {
+       #if JUCE_SAMPLECONVERSION_USE_AVX2
+        if (canUseAVX2())
+            return avx2Instructions;
+       #endif
+
+       #if JUCE_SAMPLECONVERSION_USE_SSE2
+        return sse2Instructions;
+       #elif JUCE_SAMPLECONVERSION_USE_NEON
+        return neonInstructions;
+       #else
+        return scalarInstructions;
+       #endif
+    }
+
+    // worked out while the program's starting up, so that no thread can see it half-done
+    const InstructionSet detectedInstructionSet = findInstructionSet();
+
+    ConversionKernel getIntegerKernel (InstructionSet instructionSet, int numBytes, bool bigEndian, bool dither) noexcept
+    {
+        switch (instructionSet)
+        {
+           #if JUCE_SAMPLECONVERSION_USE_AVX2
+            case avx2Instructions:  return getKernel<AVX2Ops> (numBytes, bigEndian, dither);
+           #endif
+           #if JUCE_SAMPLECONVERSION_USE_SSE2
+            case sse2Instructions:  return getKernel<SSE2Ops> (numBytes, bigEndian, dither);
+           #endif
+           #if JUCE_SAMPLECONVERSION_USE_NEON
+            case neonInstructions:  return getKernel<NeonOps> (numBytes, bigEndian, dither);
+           #endif
+            default:                return getKernel<ScalarOps> (numBytes, bigEndian, dither);
+        }
+    }
+
+    void interleaveChannels (const void* const* sourceChannels, int numChannels, void* dest,
+                             int bytesPerSample, int numFrames, bool useVectorInstructions) noexcept
+    {
+        if (useVectorInstructions && interleaveWithVectors (sourceChannels, numChannels, dest, bytesPerSample, numFrames))
+            return;
+
+        switch (bytesPerSample)
+        {
+            case 1:     interleaveTiled<1> (sourceChannels, numChannels, dest, numFrames); break;
+            case 2:     interleaveTiled<2> (sourceChannels, numChannels, dest, numFrames); break;
+            case 3:     interleaveTiled<3> (sourceChannels, numChannels, dest, numFrames); break;
+            case 4:     interleaveTiled<4> (sourceChannels, numChannels, dest, numFrames); break;
+            case 8:     interleaveTiled<8> (sourceChannels, numChannels, dest, numFrames); break;
+            default:    jassertfalse; break;
+        }
+    }
+}
+
+//==============================================================================
+int SampleConversion::getBytesPerSample (SampleFormat format) noexcept
+{
+    switch (format)
+    {
+        case int8Format:
+        case uint8Format:     return 1;
+        case int16Format:     return 2;
+        case int24Format:     return 3;
+        case int32Format:
+        case float32Format:   return 4;
+        case float64Format:   return 8;
+        default:        jassertfalse; return 0;
+    }
+}
+
+const char* SampleConversion::getInstructionSetName() noexcept
+{
+    switch (detectedInstructionSet)
+    {
+        case sse2Instructions:  return "SSE2";
+        case avx2Instructions:  return "AVX2";
+        case neonInstructions:  return "NEON";
+        default:                return "none";
+    }
+}
+
+SampleConversion::DitherState::DitherState() noexcept
+{
+    // every lane needs a different, non-zero seed
+    uint32 seed = 0x9e3779b9;
+
+    for (int i = 0; i < numElementsInArray (state); ++i)
+        state[i] = nextRandom (seed);
+}
+
+//==============================================================================
+void SampleConversion::interleave (const void* const* sourceChannels, int numChannels,
+                                   void* dest, int bytesPerSample, int numFrames) noexcept
+{
+    interleaveChannels (sourceChannels, numChannels, dest, bytesPerSample, numFrames, true);
+}
+
+void SampleConversion::deinterleave (const void* source, int numChannels,
+                                     void* const* destChannels, int bytesPerSample, int numFrames) noexcept
+{
+    switch (bytesPerSample)
+    {
+        case 1:     deinterleaveTiled<1> (source, numChannels, destChannels, numFrames); break;
+        case 2:     deinterleaveTiled<2> (source, numChannels, destChannels, numFrames); break;
+        case 3:     deinterleaveTiled<3> (source, numChannels, destChannels, numFrames); break;
+        case 4:     deinterleaveTiled<4> (source, numChannels, destChannels, numFrames); break;
+        case 8:     deinterleaveTiled<8> (source, numChannels, destChannels, numFrames); break;
+        default:    jassertfalse; break;
+    }
+}
+
+void SampleConversion::convertToInterleaved (const float* const* sourceChannels, int numChannels,
+                                             void* dest, SampleFormat destFormat, bool destIsBigEndian,
+                                             int numFrames, DitherState* dither, bool useVectorInstructions)
+{
+    if (numChannels <= 0 || numFrames <= 0)
+        return;
+
+    if (destFormat == int16Format || destFormat == int24Format || destFormat == int32Format)
+    {
+        const int bytesPerSample = getBytesPerSample (destFormat);
+        const bool shouldDither = dither != nullptr && destFormat != int32Format;
+
+        const ConversionKernel kernel = getIntegerKernel (useVectorInstructions ? detectedInstructionSet : scalarInstructions,
+                                                          bytesPerSample, destIsBigEndian, shouldDither);
+
+        kernel (sourceChannels, numChannels, dest, numFrames, shouldDither ? dither->state : nullptr);
+        return;
+    }
+
+   #if JUCE_BIG_ENDIAN
+    const bool isNativeEndian = destIsBigEndian;
+   #else
+    const bool isNativeEndian = ! destIsBigEndian;
+   #endif
+
+    if (destFormat == float32Format && isNativeEndian)
+    {
+        interleaveChannels (reinterpret_cast<const void* const*> (sourceChannels), numChannels, dest,
+                            sizeof (float), numFrames, useVectorInstructions);
+        return;
+    }
+
+    const ChannelConverterFunction convert = getChannelConverter (destFormat, destIsBigEndian);
+    const int bytesPerSample = getBytesPerSample (destFormat);
+
+    if (convert == nullptr || numChannels <= 0)
+        return;
+
+    // each tile of every channel is converted into a packed block, then interleaved from there
+    HeapBlock<char> tileData ((size_t) (numChannels * bytesPerSample * framesPerTile));
+    HeapBlock<void*> tileChannels ((size_t) numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        tileChannels[ch] = tileData + ch * bytesPerSample * framesPerTile;
+
+    for (int start = 0; start < numFrames; start += framesPerTile)
+    {
+        const int numInTile = jmin ((int) framesPerTile, numFrames - start);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (sourceChannels[ch] != nullptr)
+                convert (sourceChannels[ch] + start, tileChannels[ch], numInTile);
+            else
+                memset (tileChannels[ch], destFormat == uint8Format ? 0x80 : 0, (size_t) (numInTile * bytesPerSample));
+        }
+
+        interleaveChannels (tileChannels, numChannels, addBytesToPointer (dest, start * numChannels * bytesPerSample),
+                            bytesPerSample, numInTile, useVectorInstructions);
+    }
+}
+
+void SampleConversion::convertFromInterleaved (const void* source, int numSourceChannels,
+                                               SampleFormat sourceFormat, bool sourceIsBigEndian,
+                                               float* const* destChannels, int numDestChannels, int numFrames)
+{
+    ChannelReader<float>::convert (source, numSourceChannels, sourceFormat, sourceIsBigEndian,
+                                   destChannels, numDestChannels, numFrames);
+}
+
+void SampleConversion::convertFromInterleaved (const void* source, int numSourceChannels,
+                                               SampleFormat sourceFormat, bool sourceIsBigEndian,
+                                               int* const* destChannels, int numDestChannels, int numFrames)
+{
+    ChannelReader<int>::convert (source, numSourceChannels, sourceFormat, sourceIsBigEndian,
+                                 destChannels, numDestChannels, numFrames);
+}
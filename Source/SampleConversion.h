@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    SampleConversion.h
+    Created: 17 Oct 2026 2:36:52pm
+    Author:  David Rowland
+
+  ==============================================================================
+*/
+
+#ifndef __SAMPLECONVERSION_H_8D41E7A2__
+#define __SAMPLECONVERSION_H_8D41E7A2__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/**
+    Routines for moving blocks of samples between planar client buffers and the
+    interleaved layouts that files use.
+
+    These work through the data in short runs of frames, so that however many
+    channels there are, the part of each one that's being worked on stays in the
+    cache.
+*/
+namespace SampleConversion
+{
+    /** The sample formats that PCM files can hold. */
+    enum SampleFormat
+    {
+        int8Format,
+        uint8Format,
+        int16Format,
+        int24Format,
+        int32Format,
+        float32Format,
+        float64Format
+    };
+
+    /** Returns the number of bytes that one sample of a format takes up. */
+    int getBytesPerSample (SampleFormat format) noexcept;
+
+    /** Returns the name of the vector instructions that the conversions have picked
+        for this CPU, e.g. "AVX2", "SSE2", "NEON" or "none".
+    */
+    const char* getInstructionSetName() noexcept;
+
+    //==============================================================================
+    /** The state of the noise generator that's used to dither conversions.
+
+        Keep one of these for each stream being written, so that the noise in each
+        block carries on from the last one.
+    */
+    struct DitherState
+    {
+        DitherState() noexcept;
+
+        uint32 state [8];
+    };
+
+    //==============================================================================
+    /** Interleaves some planar channels into a block of frames.
+
+        Each sample is bytesPerSample bytes long, and is copied as it is. Any null
+        channels are written as zeros.
+    */
+    void interleave (const void* const* sourceChannels, int numChannels,
+                     void* dest, int bytesPerSample, int numFrames) noexcept;
+
+    /** Splits a block of interleaved frames into planar channels.
+        Any null channels are skipped.
+    */
+    void deinterleave (const void* source, int numChannels,
+                       void* const* destChannels, int bytesPerSample, int numFrames) noexcept;
+
+    //==============================================================================
+    /** Converts planar floats into a block of interleaved frames in the given format.
+
+        For integer formats the floats should be in the range -1 to 1, and anything
+        outside is clipped; float formats are written as they are. Any null channels
+        are written as silence.
+
+        If a DitherState is supplied, triangular noise of +/- 1 LSB is added before
+        16 and 24-bit samples are rounded. Other formats aren't dithered.
+
+        16, 24 and 32-bit integers are converted by vector kernels that scale, dither,
+        byte-swap and interleave in one pass. Native-endian float32 is only interleaved.
+        Passing false for useVectorInstructions makes it use plain C++ instead, which is
+        only there so that a benchmark can compare the two.
+    */
+    void convertToInterleaved (const float* const* sourceChannels, int numChannels,
+                               void* dest, SampleFormat destFormat, bool destIsBigEndian,
+                               int numFrames, DitherState* dither = nullptr,
+                               bool useVectorInstructions = true);
+
+    /** Converts a block of interleaved frames in the given format into planar floats.
+
+        Integer samples are scaled to the range -1 to 1. Dest channel i gets source
+        channel i, so only the first numDestChannels of the source's channels are
+        converted, and any null dest channels are skipped.
+    */
+    void convertFromInterleaved (const void* source, int numSourceChannels,
+                                 SampleFormat sourceFormat, bool sourceIsBigEndian,
+                                 float* const* destChannels, int numDestChannels, int numFrames);
+
+    /** Converts a block of interleaved frames in the given format into planar 32-bit ints.
+
+        Integer samples are shifted up so that their most significant bits are at the
+        top of the int, and float samples are scaled to its full range, with anything
+        outside -1 to 1 clipped. Channels are picked as for the float version.
+    */
+    void convertFromInterleaved (const void* source, int numSourceChannels,
+                                 SampleFormat sourceFormat, bool sourceIsBigEndian,
+                                 int* const* destChannels, int numDestChannels, int numFrames);
+}
+
+#endif  // __SAMPLECONVERSION_H_8D41E7A2__